@@ -9,14 +9,41 @@ extern "C"
 #endif
 
   AUDIENCE_API bool audience_init(const AudienceAppDetails *details, const AudienceAppEventHandler *event_handler);
+  AUDIENCE_API AudienceContext audience_context_create(const AudienceAppDetails *details, const AudienceAppEventHandler *event_handler);
+  AUDIENCE_API AudienceContext audience_context_default();
+  AUDIENCE_API void audience_context_destroy(AudienceContext context);
+  AUDIENCE_API AudienceWindowList audience_context_window_list(AudienceContext context);
+  AUDIENCE_API AudienceWindowHandle audience_context_window_create(AudienceContext context, const AudienceWindowDetails *details, const AudienceWindowEventHandler *event_handler);
+  AUDIENCE_API void audience_context_window_create_async(AudienceContext context, const AudienceWindowDetails *details, const AudienceWindowEventHandler *event_handler, AudienceWindowCompletionHandler on_complete, void *completion_context);
+  AUDIENCE_API void audience_context_publish(AudienceContext context, const char *topic, const char *message, size_t length);
+  AUDIENCE_API AudienceTimerHandle audience_context_timer_start(AudienceContext context, uint32_t interval_ms, void (*handler)(AudienceTimerHandle handle, void *context), void *handler_context);
   AUDIENCE_API AudienceScreenList audience_screen_list();
   AUDIENCE_API AudienceWindowList audience_window_list();
   AUDIENCE_API AudienceWindowHandle audience_window_create(const AudienceWindowDetails *details, const AudienceWindowEventHandler *event_handler);
+  AUDIENCE_API void audience_window_create_async(const AudienceWindowDetails *details, const AudienceWindowEventHandler *event_handler, AudienceWindowCompletionHandler on_complete, void *context);
   AUDIENCE_API void audience_window_update_position(AudienceWindowHandle handle, AudienceRect position);
+  AUDIENCE_API void audience_window_update_position_async(AudienceWindowHandle handle, AudienceRect position, AudienceWindowCompletionHandler on_complete, void *context);
+  AUDIENCE_API void audience_window_animate(AudienceWindowHandle handle, AudienceRect target, uint32_t duration_ms, AudienceEasing easing, AudienceWindowAnimationHandler on_end, void *context);
   AUDIENCE_API void audience_window_post_message(AudienceWindowHandle handle, const wchar_t *message);
+  AUDIENCE_API void audience_window_post_message_utf8(AudienceWindowHandle handle, const char *message, size_t length);
+  AUDIENCE_API void audience_window_post_messages(const AudienceMessageBatch *batch);
+  AUDIENCE_API void audience_window_post_binary(AudienceWindowHandle handle, const void *data, size_t length);
+  AUDIENCE_API void audience_state_set(AudienceWindowHandle handle, const char *path, const char *value);
+  AUDIENCE_API void audience_state_remove(AudienceWindowHandle handle, const char *path);
+  AUDIENCE_API AudienceBlobUrl audience_window_publish_blob(AudienceWindowHandle handle, const AudienceBlobDetails *details);
+  AUDIENCE_API void audience_window_revoke_blob(AudienceWindowHandle handle, const char *url);
+  AUDIENCE_API void audience_publish(const char *topic, const char *message, size_t length);
+  AUDIENCE_API AudienceTimerHandle audience_timer_start(uint32_t interval_ms, void (*handler)(AudienceTimerHandle handle, void *context), void *context);
+  AUDIENCE_API void audience_timer_stop(AudienceTimerHandle handle);
   AUDIENCE_API void audience_window_destroy(AudienceWindowHandle handle);
+  AUDIENCE_API void audience_window_destroy_async(AudienceWindowHandle handle, AudienceWindowCompletionHandler on_complete, void *context);
   AUDIENCE_API void audience_quit();
   AUDIENCE_API void audience_main();
+  // alternative to audience_main() for applications running their own event loop: wait for
+  // the fd to become readable, then call audience_poll(0). audience_poll() returns the maximum
+  // number of milliseconds until it wants to be called again, or -1 to only wait for the fd.
+  AUDIENCE_API int audience_get_event_fd();
+  AUDIENCE_API int audience_poll(int timeout_ms);
 
 #ifdef __cplusplus
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 #include <wchar.h>
 #include <stdbool.h>
 
@@ -16,6 +17,7 @@ extern "C"
 #define AUDIENCE_WINDOW_LIST_ENTRIES 20
 #define AUDIENCE_APP_DETAILS_LOAD_ORDER_ENTRIES 10
 #define AUDIENCE_APP_DETAILS_ICON_SET_ENTRIES 20
+#define AUDIENCE_BLOB_URL_LENGTH 64
 
   enum AudienceNucleusTechWindows
   {
@@ -55,6 +57,11 @@ extern "C"
   } AudienceRect;
 
   typedef uint16_t AudienceWindowHandle;
+  typedef uint32_t AudienceTimerHandle;
+
+  // isolated app session with its own windows, timers, handlers and transport settings
+  // (all contexts of a process share the nucleus and its main loop, nullptr selects the default context)
+  typedef struct AudienceContextData *AudienceContext;
 
   typedef struct
   {
@@ -72,6 +79,50 @@ extern "C"
     // - unix: sorts by width ascending and builds an icon list, which gets cut off at a certain position by the underlying system when hitting a limit
     // - macos: picks largest icon by width
     const wchar_t *icon_set[AUDIENCE_APP_DETAILS_ICON_SET_ENTRIES];
+    // transport between shell and web app (ignored by nuclei which handle messaging themselves):
+    // - compression negotiates permessage-deflate, given the web view supports it
+    // - window_bits (9..15) and mem_level (1..9) tune the deflate stream, zero selects defaults (15 and 4)
+    // - messages larger than fragment_size bytes are streamed in fragments, so they do not block smaller messages, zero selects default (65536)
+    // - the last replay_capacity messages (at most 16 MiB) are kept for replay to reconnecting web apps, zero selects default (1024)
+    // - limits bound resources per window, zero selects defaults: idle http connections are closed after 30 seconds,
+    //   unresponsive websockets after 300 seconds, request bodies are limited to 64 KiB, messages to 64 MiB,
+    //   and at most 32 connections are accepted concurrently
+    struct
+    {
+      struct
+      {
+        bool enabled;
+        uint8_t window_bits;
+        uint8_t mem_level;
+      } compression;
+      uint32_t fragment_size;
+      uint32_t replay_capacity;
+      struct
+      {
+        uint16_t http_idle_timeout;      // seconds
+        uint16_t websocket_idle_timeout; // seconds
+        uint32_t body_limit;
+        uint32_t message_limit;
+        uint16_t max_connections;
+      } limits;
+    } transport;
+    // worker pool for windows with AUDIENCE_EVENT_DELIVERY_WORKER_POOL:
+    // - pool_size threads are started with the first of those windows, zero selects default (2)
+    // - at most queue_limit messages are pending per window, zero selects default (256),
+    //   further messages are held back at the transport until the handlers caught up
+    struct
+    {
+      uint8_t pool_size;
+      uint32_t queue_limit;
+    } workers;
+    // warm web views (unix only):
+    // - pool_size hidden windows with web views are created upfront and handed out on window creation
+    // - closed windows get a fresh web view (sharing the web process) and are returned to the pool instead of being destroyed
+    // - zero disables the pool, only the details of the context loading the nucleus apply
+    struct
+    {
+      uint8_t pool_size;
+    } webviews;
   } AudienceAppDetails;
 
   typedef struct
@@ -107,6 +158,37 @@ extern "C"
     } on_quit;
   } AudienceAppEventHandler;
 
+  typedef struct
+  {
+    AudienceWindowHandle handle;
+    const char *message; // utf-8
+    size_t length;
+  } AudienceMessage;
+
+  typedef struct
+  {
+    const AudienceMessage *messages;
+    size_t count;
+  } AudienceMessageBatch;
+
+  // memory served to the web app without copying, data has to stay valid until on_release is called (on the main thread, unless shutting down)
+  typedef struct
+  {
+    const void *data;
+    size_t length;
+    const char *mime_type; // defaults to "application/octet-stream"
+    struct
+    {
+      void (*handler)(void *context);
+      void *context;
+    } on_release;
+  } AudienceBlobDetails;
+
+  typedef struct
+  {
+    char url[AUDIENCE_BLOB_URL_LENGTH]; // relative to the web app, empty on failure
+  } AudienceBlobUrl;
+
   enum AudienceWebAppType
   {
     AUDIENCE_WEBAPP_TYPE_DIRECTORY = 0,
@@ -132,6 +214,27 @@ extern "C"
     bool dev_mode;
   } AudienceWindowDetails;
 
+  // called on the main thread once an asynchronous window operation completed (handle is zero if window creation failed)
+  typedef void (*AudienceWindowCompletionHandler)(AudienceWindowHandle handle, void *context);
+
+  enum AudienceEasing
+  {
+    AUDIENCE_EASING_LINEAR = 0,
+    AUDIENCE_EASING_EASE_IN = 1,
+    AUDIENCE_EASING_EASE_OUT = 2,
+    AUDIENCE_EASING_EASE_IN_OUT = 3
+  };
+
+  // called on the main thread once a window animation ended, completed is false if it got interrupted
+  // (by another animation, a position update or the window closing)
+  typedef void (*AudienceWindowAnimationHandler)(AudienceWindowHandle handle, void *context, bool completed);
+
+  enum AudienceEventDelivery
+  {
+    AUDIENCE_EVENT_DELIVERY_MAIN_THREAD = 0,
+    AUDIENCE_EVENT_DELIVERY_WORKER_POOL = 1
+  };
+
   typedef struct
   {
     struct
@@ -149,6 +252,38 @@ extern "C"
       void (*handler)(AudienceWindowHandle handle, void *context, bool is_last_window);
       void *context;
     } on_close;
+    // members below got appended later, keep appending to stay binary compatible
+    struct
+    {
+      void (*handler)(AudienceWindowHandle handle, void *context, const void *data, size_t length);
+      void *context;
+    } on_binary;
+    // utf-8 variant of on_message, takes precedence over on_message if set (message is not null terminated)
+    struct
+    {
+      void (*handler)(AudienceWindowHandle handle, void *context, const char *message, size_t length);
+      void *context;
+    } on_message_utf8;
+    // web app reconnected, but messages got lost in between (replay capacity exceeded or shell restarted)
+    struct
+    {
+      void (*handler)(AudienceWindowHandle handle, void *context);
+      void *context;
+    } on_resync;
+    // worker pool delivery applies to on_message, on_message_utf8 and on_binary, which are then called
+    // on a shell managed thread, in order per window (all other handlers are called on the main thread)
+    AudienceEventDelivery message_delivery;
+    // window got moved or resized by the user or the application, coalesced to at most one call per frame
+    struct
+    {
+      void (*handler)(AudienceWindowHandle handle, void *context, AudienceRect frame, AudienceSize workspace);
+      void *context;
+    } on_geometry_change;
+    struct
+    {
+      void (*handler)(AudienceWindowHandle handle, void *context, bool has_focus);
+      void *context;
+    } on_focus_change;
   } AudienceWindowEventHandler;
 
 #pragma pack(pop)
@@ -17,6 +17,8 @@ export type AudienceRect = AudienceSize & {
   y: number;
 };
 
+export type AudienceEasing = 'linear' | 'ease_in' | 'ease_out' | 'ease_in_out';
+
 export type AudienceScreenList = {
   focused: number;
   primary: number;
@@ -47,15 +49,24 @@ export type AudienceWindowDetails = {
   dev?: boolean;
 };
 
-type _EventCallbackWindowMessage = (data: { handle: AudienceWindowHandle, message: string }) => void;
+// payload is set instead of message, if jsonPayload is enabled and the message is valid JSON
+type _EventCallbackWindowMessage = (data: { handle: AudienceWindowHandle, message: string, payload?: any }) => void;
+type _EventCallbackWindowBinary = (data: { handle: AudienceWindowHandle, data: Buffer }) => void;
+type _EventCallbackWindowResync = (data: { handle: AudienceWindowHandle }) => void;
 type _EventCallbackWindowCloseIntent = (data: { handle: AudienceWindowHandle }) => void;
 type _EventCallbackWindowClose = (data: { handle: AudienceWindowHandle, is_last_window: boolean }) => void;
+type _EventCallbackWindowGeometryChange = (data: { handle: AudienceWindowHandle, frame: AudienceRect, workspace: AudienceSize }) => void;
+type _EventCallbackWindowFocusChange = (data: { handle: AudienceWindowHandle, has_focus: boolean }) => void;
 type _EventCallbackAppQuit = () => void;
 
 type _EventCallbackAny =
   _EventCallbackWindowMessage |
+  _EventCallbackWindowBinary |
+  _EventCallbackWindowResync |
   _EventCallbackWindowCloseIntent |
   _EventCallbackWindowClose |
+  _EventCallbackWindowGeometryChange |
+  _EventCallbackWindowFocusChange |
   _EventCallbackAppQuit;
 
 export interface AudienceApi {
@@ -64,13 +75,26 @@ export interface AudienceApi {
   windowList(): Promise<AudienceWindowList>;
   windowCreate(details: AudienceWindowDetails): Promise<AudienceWindowHandle>;
   windowUpdatePosition(handle: AudienceWindowHandle, position: AudienceRect): Promise<void>;
+  windowAnimate(handle: AudienceWindowHandle, target: AudienceRect, duration: number, easing?: AudienceEasing): Promise<{ completed: boolean }>;
   windowPostMessage(handle: AudienceWindowHandle, message: string): Promise<void>;
+  windowPostPayload(handle: AudienceWindowHandle, payload: any): Promise<void>;
+  windowPostMessages(messages: Array<{ handle: AudienceWindowHandle, message: string }>): Promise<void>;
+  windowPostBinary(handle: AudienceWindowHandle, data: Uint8Array): Promise<void>;
+  windowPublishBlob(handle: AudienceWindowHandle, data: Uint8Array, mimeType?: string): Promise<string>;
+  windowRevokeBlob(handle: AudienceWindowHandle, url: string): Promise<void>;
+  stateSet(handle: AudienceWindowHandle, path: string, value: any): Promise<void>;
+  stateRemove(handle: AudienceWindowHandle, path: string): Promise<void>;
+  publish(topic: string, message: string): Promise<void>;
   windowDestroy(handle: AudienceWindowHandle): Promise<void>;
   quit(): Promise<void>;
   // Events
   onWindowMessage(callback: _EventCallbackWindowMessage): void;
+  onWindowBinary(callback: _EventCallbackWindowBinary): void;
+  onWindowResync(callback: _EventCallbackWindowResync): void;
   onWindowCloseIntent(callback: _EventCallbackWindowCloseIntent): void;
   onWindowClose(callback: _EventCallbackWindowClose): void;
+  onWindowGeometryChange(callback: _EventCallbackWindowGeometryChange): void;
+  onWindowFocusChange(callback: _EventCallbackWindowFocusChange): void;
   onAppQuit(callback: _EventCallbackAppQuit): void;
   off(callback?: _EventCallbackAny): void;
   futureExit(): Promise<void>;
@@ -81,6 +105,9 @@ export type AudienceOptions = {
   mac?: string[],
   unix?: string[],
   icons?: string[],
+  compression?: boolean,
+  webviewPool?: number,
+  jsonPayload?: boolean,
   runtime?: string,
   debug?: boolean,
 };
@@ -88,10 +115,14 @@ export type AudienceOptions = {
 export async function audience(options?: AudienceOptions): Promise<AudienceApi> {
 
   const activeCommands = new Map<string, { reject: (error: Error) => void, resolve: (result?: any) => void }>();
-  const eventHandler = new Map<'window_message' | 'window_close_intent' | 'window_close' | 'app_quit', Set<_EventCallbackAny>>([
+  const eventHandler = new Map<'window_message' | 'window_binary' | 'window_resync' | 'window_close_intent' | 'window_close' | 'window_geometry_change' | 'window_focus_change' | 'app_quit', Set<_EventCallbackAny>>([
     ['window_message', new Set<_EventCallbackAny>()],
+    ['window_binary', new Set<_EventCallbackAny>()],
+    ['window_resync', new Set<_EventCallbackAny>()],
     ['window_close_intent', new Set<_EventCallbackAny>()],
     ['window_close', new Set<_EventCallbackAny>()],
+    ['window_geometry_change', new Set<_EventCallbackAny>()],
+    ['window_focus_change', new Set<_EventCallbackAny>()],
     ['app_quit', new Set<_EventCallbackAny>()],
   ]);
 
@@ -110,6 +141,9 @@ export async function audience(options?: AudienceOptions): Promise<AudienceApi>
       }
     }
     else if (eventHandler.has(<any>name)) {
+      if (name == 'window_binary') {
+        data = { handle: data.handle, data: Buffer.from(data.data, 'base64') };
+      }
       eventHandler.get(<any>name)!.forEach((callback) => {
         try {
           Promise.resolve(callback(data))
@@ -159,6 +193,9 @@ export async function audience(options?: AudienceOptions): Promise<AudienceApi>
       ...(options && options.mac ? ['--mac', options.mac.join(',')] : []),
       ...(options && options.unix ? ['--unix', options.unix.join(',')] : []),
       ...(options && options.icons ? ['--icons', options.icons.join(',')] : []),
+      ...(options && options.compression ? ['--compression'] : []),
+      ...(options && options.webviewPool ? ['--webview-pool', options.webviewPool.toString()] : []),
+      ...(options && options.jsonPayload ? ['--channel-json-payload'] : []),
     ]
   );
   const futureExit = new Promise<void>((resolve, reject) => {
@@ -209,9 +246,37 @@ export async function audience(options?: AudienceOptions): Promise<AudienceApi>
     windowUpdatePosition(handle: AudienceWindowHandle, position: AudienceRect): Promise<void> {
       return dispatchCommand('window_update_position', { handle, ...position });
     },
+    windowAnimate(handle: AudienceWindowHandle, target: AudienceRect, duration: number, easing?: AudienceEasing): Promise<{ completed: boolean }> {
+      return dispatchCommand('window_animate', { handle, ...target, duration, easing });
+    },
     windowPostMessage(handle: AudienceWindowHandle, message: string): Promise<void> {
       return dispatchCommand('window_post_message', { handle, message });
     },
+    windowPostPayload(handle: AudienceWindowHandle, payload: any): Promise<void> {
+      return dispatchCommand('window_post_message', { handle, payload });
+    },
+    windowPostMessages(messages: Array<{ handle: AudienceWindowHandle, message: string }>): Promise<void> {
+      return dispatchCommand('batch', { messages });
+    },
+    windowPostBinary(handle: AudienceWindowHandle, data: Uint8Array): Promise<void> {
+      return dispatchCommand('window_post_binary', { handle, data: Buffer.from(data.buffer, data.byteOffset, data.byteLength).toString('base64') });
+    },
+    windowPublishBlob(handle: AudienceWindowHandle, data: Uint8Array, mimeType?: string): Promise<string> {
+      return dispatchCommand('window_publish_blob', { handle, data: Buffer.from(data.buffer, data.byteOffset, data.byteLength).toString('base64'), mime_type: mimeType })
+        .then((result: { url: string }) => result.url);
+    },
+    windowRevokeBlob(handle: AudienceWindowHandle, url: string): Promise<void> {
+      return dispatchCommand('window_revoke_blob', { handle, url });
+    },
+    stateSet(handle: AudienceWindowHandle, path: string, value: any): Promise<void> {
+      return dispatchCommand('state_set', { handle, path, value });
+    },
+    stateRemove(handle: AudienceWindowHandle, path: string): Promise<void> {
+      return dispatchCommand('state_remove', { handle, path });
+    },
+    publish(topic: string, message: string): Promise<void> {
+      return dispatchCommand('publish', { topic, message });
+    },
     windowDestroy(handle: AudienceWindowHandle): Promise<void> {
       return dispatchCommand('window_destroy', { handle });
     },
@@ -222,12 +287,24 @@ export async function audience(options?: AudienceOptions): Promise<AudienceApi>
     onWindowMessage(callback: _EventCallbackWindowMessage): void {
       eventHandler.get('window_message')!.add(callback);
     },
+    onWindowBinary(callback: _EventCallbackWindowBinary): void {
+      eventHandler.get('window_binary')!.add(callback);
+    },
+    onWindowResync(callback: _EventCallbackWindowResync): void {
+      eventHandler.get('window_resync')!.add(callback);
+    },
     onWindowCloseIntent(callback: _EventCallbackWindowCloseIntent): void {
       eventHandler.get('window_close_intent')!.add(callback);
     },
     onWindowClose(callback: _EventCallbackWindowClose): void {
       eventHandler.get('window_close')!.add(callback);
     },
+    onWindowGeometryChange(callback: _EventCallbackWindowGeometryChange): void {
+      eventHandler.get('window_geometry_change')!.add(callback);
+    },
+    onWindowFocusChange(callback: _EventCallbackWindowFocusChange): void {
+      eventHandler.get('window_focus_change')!.add(callback);
+    },
     onAppQuit(callback: _EventCallbackAppQuit): void {
       eventHandler.get('app_quit')!.add(callback);
     },
@@ -3,6 +3,19 @@ interface Window {
     postMessage: (message: string) => void;
     onMessage: (handler: (message: string) => void) => void;
     offMessage: (handler: ((message: string) => void) | undefined) => void;
+    postBinary: (data: ArrayBuffer | ArrayBufferView) => void;
+    onBinary: (handler: (data: ArrayBuffer) => void) => void;
+    offBinary: (handler: ((data: ArrayBuffer) => void) | undefined) => void;
+    onResync: (handler: () => void) => void;
+    offResync: (handler: (() => void) | undefined) => void;
+    subscribe: (topic: string, handler: (message: string, topic: string) => void) => void;
+    unsubscribe: (topic: string, handler: ((message: string, topic: string) => void) | undefined) => void;
+    state: {
+      get: (path?: string) => any;
+      version: () => number;
+      onChange: (handler: (state: any) => void) => void;
+      offChange: (handler: ((state: any) => void) | undefined) => void;
+    };
   },
   _audienceWebviewSignature?: 'edge';
   _audienceWebviewMessageHandler?: (message: string) => void;
@@ -12,48 +25,200 @@ interface External {
   notify?: (message: string) => void;
 }
 
+type Message = string | ArrayBuffer;
+
 interface BackendConstructor {
   new(
     readyHandler: () => void,
-    messageHandler: (message: string) => void
+    messageHandler: (message: Message) => void,
+    controlHandler: (message: any) => void
   ): Backend;
 }
 
 interface Backend {
   ready: () => boolean;
-  send: (message: string) => void;
+  send: (message: Message) => void;
+  sendControl: (message: any) => void;
 }
 
 // prevent double initialization
 if (window.audience !== undefined)
   throw new Error('double initialization of audience frontend detected');
 
+// websocket framing, see websocket_session.impl.h:
+// - text frames carry plain messages
+// - binary frames start with a kind byte (0 = binary message, 1 = fragment, 2 = control message)
+// - fragments carry a flags byte (1 = binary, 2 = last, 4 = control) and a message id (uint32, little endian)
+const FRAME_BINARY = 0;
+const FRAME_FRAGMENT = 1;
+const FRAME_CONTROL = 2;
+const FRAGMENT_BINARY = 1;
+const FRAGMENT_LAST = 2;
+const FRAGMENT_CONTROL = 4;
+const FRAGMENT_HEADER_SIZE = 6;
+const FRAGMENT_SIZE = 64 * 1024;
+
 // backend implementations
 const WebsocketBackend: BackendConstructor = class implements Backend {
-  private ws = new WebSocket('ws' + window.location.origin.substr(4));
+  private ws!: WebSocket;
+  private reconnectDelay = 0;
+  private fragments = new Map<number, { seq: number, parts: Array<Uint8Array> }>();
+  private nextFragmentId = 0;
+  // user messages are sequenced by the shell in the order they start, which allows resuming after reconnects and reloads
+  private session = { epoch: '', nextSeq: 0, lastSeq: 0, completed: new Set<number>() };
   constructor(
     private readyHandler: () => void,
-    private messageHandler: (message: string) => void
+    private messageHandler: (message: Message) => void,
+    private controlHandler: (message: any) => void
   ) {
+    try {
+      const resume = JSON.parse(window.sessionStorage.getItem('audience.session') || 'null');
+      if (resume && typeof resume.epoch == 'string' && typeof resume.seq == 'number') {
+        this.session.epoch = resume.epoch;
+        this.session.lastSeq = resume.seq;
+      }
+      window.addEventListener('pagehide', () => {
+        window.sessionStorage.setItem('audience.session', JSON.stringify({ epoch: this.session.epoch, seq: this.session.lastSeq }));
+      });
+    }
+    catch (error) {
+      console.error(error);
+    }
+    this.connect();
+  }
+  private connect() {
+    const query = this.session.epoch != '' ? '/?epoch=' + encodeURIComponent(this.session.epoch) + '&seq=' + this.session.lastSeq : '';
+    this.ws = new WebSocket('ws' + window.location.origin.substr(4) + query);
+    this.ws.binaryType = 'arraybuffer';
     this.ws.addEventListener('open', () => {
+      this.reconnectDelay = 0;
       this.readyHandler();
     });
-    this.ws.addEventListener('message', (event: { data: string }) => {
-      this.messageHandler(event.data);
+    this.ws.addEventListener('message', (event: { data: Message }) => {
+      this.receive(event.data);
+    });
+    this.ws.addEventListener('close', () => {
+      // partially received messages are replayed as a whole
+      this.fragments.clear();
+      this.reconnectDelay = Math.min(Math.max(this.reconnectDelay * 2, 250), 5000);
+      setTimeout(() => this.connect(), this.reconnectDelay);
     });
   }
   ready() {
     return this.ws.readyState == 1;
   }
-  send(message: string) {
-    this.ws.send(message);
+  send(message: Message) {
+    // utf-16 code units expand to at most 3 bytes, encode only if the message could exceed a fragment
+    if (typeof message == 'string' && message.length * 3 <= FRAGMENT_SIZE) {
+      this.ws.send(message);
+      return;
+    }
+    const data = typeof message == 'string' ? new TextEncoder().encode(message) : new Uint8Array(message);
+    if (typeof message == 'string' && data.byteLength <= FRAGMENT_SIZE) {
+      this.ws.send(message);
+    }
+    else {
+      this.sendFramed(data, typeof message == 'string' ? 0 : FRAGMENT_BINARY);
+    }
+  }
+  sendControl(message: any) {
+    this.sendFramed(new TextEncoder().encode(JSON.stringify(message)), FRAGMENT_CONTROL);
+  }
+  private sendFramed(data: Uint8Array, type: number) {
+    if (data.byteLength <= FRAGMENT_SIZE) {
+      const frame = new Uint8Array(1 + data.byteLength);
+      frame[0] = type == FRAGMENT_CONTROL ? FRAME_CONTROL : FRAME_BINARY;
+      frame.set(data, 1);
+      this.ws.send(frame.buffer);
+    }
+    else {
+      const id = this.nextFragmentId++ >>> 0;
+      for (let offset = 0; offset < data.byteLength; offset += FRAGMENT_SIZE) {
+        const slice = data.subarray(offset, offset + FRAGMENT_SIZE);
+        const frame = new Uint8Array(FRAGMENT_HEADER_SIZE + slice.byteLength);
+        const flags = type | (offset + slice.byteLength == data.byteLength ? FRAGMENT_LAST : 0);
+        frame[0] = FRAME_FRAGMENT;
+        frame[1] = flags;
+        new DataView(frame.buffer).setUint32(2, id, true);
+        frame.set(slice, FRAGMENT_HEADER_SIZE);
+        this.ws.send(frame.buffer);
+      }
+    }
+  }
+  private receive(data: Message) {
+    if (typeof data == 'string') {
+      this.deliver(this.session.nextSeq++, data);
+      return;
+    }
+    const frame = new Uint8Array(data);
+    if (frame.byteLength >= 1 && frame[0] == FRAME_BINARY) {
+      this.deliver(this.session.nextSeq++, data.slice(1));
+    }
+    else if (frame.byteLength >= 1 && frame[0] == FRAME_CONTROL) {
+      this.receiveControl(JSON.parse(new TextDecoder().decode(frame.subarray(1))));
+    }
+    else if (frame.byteLength >= FRAGMENT_HEADER_SIZE && frame[0] == FRAME_FRAGMENT) {
+      const flags = frame[1];
+      const id = new DataView(data).getUint32(2, true);
+      let fragment = this.fragments.get(id);
+      if (fragment === undefined) {
+        fragment = { seq: flags & FRAGMENT_CONTROL ? 0 : this.session.nextSeq++, parts: [] };
+        this.fragments.set(id, fragment);
+      }
+      const parts = fragment.parts;
+      parts.push(frame.subarray(FRAGMENT_HEADER_SIZE));
+      if (flags & FRAGMENT_LAST) {
+        this.fragments.delete(id);
+        const message = new Uint8Array(parts.reduce((size, part) => size + part.byteLength, 0));
+        parts.reduce((offset, part) => (message.set(part, offset), offset + part.byteLength), 0);
+        if (flags & FRAGMENT_CONTROL) {
+          this.receiveControl(JSON.parse(new TextDecoder().decode(message)));
+        }
+        else {
+          this.deliver(fragment.seq, flags & FRAGMENT_BINARY ? message.buffer : new TextDecoder().decode(message));
+        }
+      }
+    }
+    else {
+      console.error('received malformed binary frame');
+    }
+  }
+  private receiveControl(message: any) {
+    if (message.type == 'session') {
+      // messages before seq are either delivered already or lost
+      if (message.resync || message.epoch != this.session.epoch) {
+        this.session.completed.clear();
+      }
+      this.session.epoch = message.epoch;
+      this.session.nextSeq = message.seq;
+      this.session.lastSeq = message.seq - 1;
+      this.session.completed.forEach((seq) => {
+        if (seq <= this.session.lastSeq)
+          this.session.completed.delete(seq);
+      });
+      if (message.resync)
+        this.controlHandler({ type: 'resync' });
+      return;
+    }
+    this.controlHandler(message);
+  }
+  private deliver(seq: number, message: Message) {
+    // skip messages which got replayed, but were delivered already
+    if (seq <= this.session.lastSeq || this.session.completed.has(seq))
+      return;
+    this.session.completed.add(seq);
+    while (this.session.completed.has(this.session.lastSeq + 1)) {
+      this.session.completed.delete(++this.session.lastSeq);
+    }
+    this.messageHandler(message);
   }
 };
 
 const EdgeWebviewBackend: BackendConstructor = class implements Backend {
   constructor(
     private readyHandler: () => void,
-    private messageHandler: (message: string) => void
+    private messageHandler: (message: Message) => void,
+    _controlHandler: (message: any) => void
   ) {
     setTimeout(() => {
       this.readyHandler();
@@ -65,24 +230,96 @@ const EdgeWebviewBackend: BackendConstructor = class implements Backend {
   ready() {
     return window.external !== undefined;
   }
-  send(message: string) {
+  send(message: Message) {
+    if (typeof message != 'string')
+      throw new Error('binary messages are not supported by this webview');
     // IMPORTANT: DO NOT CHECK IF window.external.notify IS undefined.
     //            IT IS undefined!, EVEN THOUGH YOU CAN STILL CALL IT.
     //            VERY WEIRD MICROSOFT STUFF!
     // lets perform a typecast to make typescript happy...
     (<(message: string) => void>window.external.notify)(message);
   }
+  sendControl(_message: any) {
+    throw new Error('control messages are not supported by this webview');
+  }
 };
 
 // message queues and handlers
 let backend: Backend;
 
 const queues = {
-  in: <Array<string>>[],
-  out: <Array<string>>[]
+  in: <Array<Message>>[],
+  out: <Array<Message>>[]
+};
+
+const handlers = {
+  message: <Set<(message: string) => void>>new Set(),
+  binary: <Set<(data: ArrayBuffer) => void>>new Set(),
+  state: <Set<(state: any) => void>>new Set(),
+  resync: <Set<() => void>>new Set()
+};
+
+// topic subscriptions, announced to the shell whenever the backend becomes ready
+const subscriptions = new Map<string, Set<(message: string, topic: string) => void>>();
+
+// state mirror, kept in sync by the shell via snapshots and json patches
+const state = {
+  version: 0,
+  data: <any>{},
+  syncing: false
 };
 
-const handlers: Set<(message: string) => void> = new Set();
+function requestStateSync() {
+  if (state.syncing)
+    return;
+  state.syncing = true;
+  try {
+    backend.sendControl({ type: 'state_sync' });
+  }
+  catch (error) {
+    state.syncing = false;
+    console.error(error);
+  }
+}
+
+function decodePointer(path: string) {
+  if (path == '')
+    return [];
+  return path.substr(1).split('/').map(function (token) {
+    return token.replace(/~1/g, '/').replace(/~0/g, '~');
+  });
+}
+
+function applyPatch(document: any, patch: Array<{ op: string, path: string, value?: any }>) {
+  patch.forEach(function (operation) {
+    const tokens = decodePointer(operation.path);
+    if (tokens.length == 0) {
+      document = operation.op == 'remove' ? {} : operation.value;
+      return;
+    }
+    let parent = document;
+    for (let i = 0; i < tokens.length - 1; ++i) {
+      parent = parent[tokens[i]];
+    }
+    const key = tokens[tokens.length - 1];
+    if (Array.isArray(parent)) {
+      const index = key == '-' ? parent.length : parseInt(key, 10);
+      if (operation.op == 'add')
+        parent.splice(index, 0, operation.value);
+      else if (operation.op == 'remove')
+        parent.splice(index, 1);
+      else
+        parent[index] = operation.value;
+    }
+    else {
+      if (operation.op == 'remove')
+        delete parent[key];
+      else
+        parent[key] = operation.value;
+    }
+  });
+  return document;
+}
 
 function pushToBackend() {
   while (backend.ready() && queues.out.length > 0) {
@@ -98,11 +335,25 @@ function pushToBackend() {
 }
 
 function pushToHandlers() {
-  while (handlers.size > 0 && queues.in.length > 0) {
+  while (queues.in.length > 0) {
+    const message = queues.in[0];
     try {
-      handlers.forEach(function (handler) {
-        handler(queues.in[0]);
-      });
+      if (typeof message == 'string') {
+        if (handlers.message.size == 0)
+          break;
+        handlers.message.forEach(function (handler) {
+          handler(message);
+        });
+      }
+      else if (handlers.binary.size > 0) {
+        handlers.binary.forEach(function (handler) {
+          handler(message);
+        });
+      }
+      else {
+        // binary messages are not buffered for handlers registered later, they would hold back all string messages
+        console.warn('dropping binary message, no binary handler registered');
+      }
       queues.in.shift();
     }
     catch (error) {
@@ -114,19 +365,83 @@ function pushToHandlers() {
 
 // instatiate backend
 function backendReadyHandler() {
+  subscriptions.forEach(function (_handlers, topic) {
+    try {
+      backend.sendControl({ type: 'subscribe', topic: topic });
+    }
+    catch (error) {
+      console.error(error);
+    }
+  });
   pushToBackend();
 }
 
-function backendMessageHandler(message: string) {
-  if (typeof message != 'string')
-    throw new Error('only string messages are supported');
+function backendMessageHandler(message: Message) {
+  if (typeof message != 'string' && !(message instanceof ArrayBuffer))
+    throw new Error('only string and binary messages are supported');
   queues.in.push(message);
   pushToHandlers();
 }
 
+function backendControlHandler(message: any) {
+  if (message.type == 'resync') {
+    handlers.resync.forEach(function (handler) {
+      try {
+        handler();
+      }
+      catch (error) {
+        console.error(error);
+      }
+    });
+    return;
+  }
+  if (message.type == 'publish') {
+    const topicHandlers = subscriptions.get(message.topic);
+    if (topicHandlers) {
+      topicHandlers.forEach(function (handler) {
+        try {
+          handler(message.message, message.topic);
+        }
+        catch (error) {
+          console.error(error);
+        }
+      });
+    }
+    return;
+  }
+  if (message.type == 'state') {
+    // snapshots replace the mirror, control messages arrive in order so they are never stale
+    state.data = message.state;
+    state.version = message.version;
+    state.syncing = false;
+  }
+  else if (message.type == 'state_patch') {
+    // patches apply on top of their predecessor only, ask for a snapshot on gaps
+    if (message.version <= state.version)
+      return;
+    if (message.version != state.version + 1) {
+      requestStateSync();
+      return;
+    }
+    state.data = applyPatch(state.data, message.patch);
+    state.version = message.version;
+  }
+  else {
+    return;
+  }
+  handlers.state.forEach(function (handler) {
+    try {
+      handler(state.data);
+    }
+    catch (error) {
+      console.error(error);
+    }
+  });
+}
+
 backend = window._audienceWebviewSignature == 'edge'
-  ? new EdgeWebviewBackend(backendReadyHandler, backendMessageHandler)
-  : new WebsocketBackend(backendReadyHandler, backendMessageHandler);
+  ? new EdgeWebviewBackend(backendReadyHandler, backendMessageHandler, backendControlHandler)
+  : new WebsocketBackend(backendReadyHandler, backendMessageHandler, backendControlHandler);
 
 // register public interface
 window.audience = {
@@ -137,14 +452,99 @@ window.audience = {
     pushToBackend();
   },
   onMessage: function (handler) {
-    handlers.add(handler);
+    handlers.message.add(handler);
+    pushToHandlers();
   },
   offMessage: function (handler) {
     if (handler !== undefined) {
-      handlers.delete(handler);
+      handlers.message.delete(handler);
     }
     else {
-      handlers.clear();
+      handlers.message.clear();
+    }
+  },
+  postBinary: function (data) {
+    if (data instanceof ArrayBuffer) {
+      queues.out.push(data);
+    }
+    else if (ArrayBuffer.isView(data)) {
+      queues.out.push(data.buffer.slice(data.byteOffset, data.byteOffset + data.byteLength));
+    }
+    else {
+      throw new Error('only ArrayBuffer and typed array messages are supported');
+    }
+    pushToBackend();
+  },
+  onBinary: function (handler) {
+    handlers.binary.add(handler);
+    pushToHandlers();
+  },
+  offBinary: function (handler) {
+    if (handler !== undefined) {
+      handlers.binary.delete(handler);
+    }
+    else {
+      handlers.binary.clear();
+    }
+  },
+  onResync: function (handler) {
+    handlers.resync.add(handler);
+  },
+  offResync: function (handler) {
+    if (handler !== undefined) {
+      handlers.resync.delete(handler);
+    }
+    else {
+      handlers.resync.clear();
+    }
+  },
+  subscribe: function (topic, handler) {
+    let topicHandlers = subscriptions.get(topic);
+    if (topicHandlers === undefined) {
+      topicHandlers = new Set();
+      subscriptions.set(topic, topicHandlers);
+      if (backend.ready())
+        backend.sendControl({ type: 'subscribe', topic: topic });
+    }
+    topicHandlers.add(handler);
+  },
+  unsubscribe: function (topic, handler) {
+    const topicHandlers = subscriptions.get(topic);
+    if (topicHandlers === undefined)
+      return;
+    if (handler !== undefined) {
+      topicHandlers.delete(handler);
+    }
+    else {
+      topicHandlers.clear();
+    }
+    if (topicHandlers.size == 0) {
+      subscriptions.delete(topic);
+      if (backend.ready())
+        backend.sendControl({ type: 'unsubscribe', topic: topic });
+    }
+  },
+  state: {
+    get: function (path) {
+      let value = state.data;
+      decodePointer(path || '').forEach(function (token) {
+        value = value !== undefined && value !== null ? value[token] : undefined;
+      });
+      return value;
+    },
+    version: function () {
+      return state.version;
+    },
+    onChange: function (handler) {
+      handlers.state.add(handler);
+    },
+    offChange: function (handler) {
+      if (handler !== undefined) {
+        handlers.state.delete(handler);
+      }
+      else {
+        handlers.state.clear();
+      }
     }
   }
 };
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <stdexcept>
+#include <cstdint>
+
+inline std::string base64_encode(const void *data, size_t length)
+{
+  static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  auto bytes = static_cast<const unsigned char *>(data);
+  std::string result;
+  result.reserve(((length + 2) / 3) * 4);
+
+  size_t i = 0;
+  for (; i + 2 < length; i += 3)
+  {
+    uint32_t triple = (bytes[i] << 16) | (bytes[i + 1] << 8) | bytes[i + 2];
+    result.push_back(alphabet[(triple >> 18) & 0x3f]);
+    result.push_back(alphabet[(triple >> 12) & 0x3f]);
+    result.push_back(alphabet[(triple >> 6) & 0x3f]);
+    result.push_back(alphabet[triple & 0x3f]);
+  }
+
+  if (i < length)
+  {
+    uint32_t triple = bytes[i] << 16;
+    if (i + 1 < length)
+    {
+      triple |= bytes[i + 1] << 8;
+    }
+    result.push_back(alphabet[(triple >> 18) & 0x3f]);
+    result.push_back(alphabet[(triple >> 12) & 0x3f]);
+    result.push_back(i + 1 < length ? alphabet[(triple >> 6) & 0x3f] : '=');
+    result.push_back('=');
+  }
+
+  return result;
+}
+
+inline std::string base64_decode(const std::string &data)
+{
+  auto decode_char = [](char c) -> uint32_t {
+    if (c >= 'A' && c <= 'Z')
+      return c - 'A';
+    if (c >= 'a' && c <= 'z')
+      return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+      return c - '0' + 52;
+    if (c == '+')
+      return 62;
+    if (c == '/')
+      return 63;
+    throw std::invalid_argument("invalid base64 character");
+  };
+
+  if (data.length() % 4 != 0)
+  {
+    throw std::invalid_argument("invalid base64 length");
+  }
+
+  std::string result;
+  result.reserve((data.length() / 4) * 3);
+
+  for (size_t i = 0; i < data.length(); i += 4)
+  {
+    uint32_t quad = (decode_char(data[i]) << 18) | (decode_char(data[i + 1]) << 12);
+    result.push_back(static_cast<char>((quad >> 16) & 0xff));
+    if (data[i + 2] != '=')
+    {
+      quad |= decode_char(data[i + 2]) << 6;
+      result.push_back(static_cast<char>((quad >> 8) & 0xff));
+      if (data[i + 3] != '=')
+      {
+        quad |= decode_char(data[i + 3]);
+        result.push_back(static_cast<char>(quad & 0xff));
+      }
+    }
+  }
+
+  return result;
+}
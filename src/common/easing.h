@@ -0,0 +1,29 @@
+#pragma once
+
+#include <algorithm>
+#include <audience_details.h>
+
+// maps linear progress t in [0, 1] onto the easing curve (cubic)
+static inline double easing_apply(AudienceEasing easing, double t)
+{
+  t = std::clamp(t, 0.0, 1.0);
+  switch (easing)
+  {
+  case AUDIENCE_EASING_EASE_IN:
+    return t * t * t;
+  case AUDIENCE_EASING_EASE_OUT:
+    return 1.0 - (1.0 - t) * (1.0 - t) * (1.0 - t);
+  case AUDIENCE_EASING_EASE_IN_OUT:
+    return t < 0.5 ? 4.0 * t * t * t : 1.0 - 4.0 * (1.0 - t) * (1.0 - t) * (1.0 - t);
+  default:
+    return t;
+  }
+}
+
+static inline AudienceRect easing_interpolate(const AudienceRect &from, const AudienceRect &to, AudienceEasing easing, double t)
+{
+  auto e = easing_apply(easing, t);
+  auto lerp = [e](double a, double b) { return a + (b - a) * e; };
+  return AudienceRect{{lerp(from.origin.x, to.origin.x), lerp(from.origin.y, to.origin.y)},
+                      {lerp(from.size.width, to.size.width), lerp(from.size.height, to.size.height)}};
+}
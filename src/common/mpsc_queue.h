@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+
+struct mpsc_node
+{
+  std::atomic<mpsc_node *> next{nullptr};
+};
+
+// Intrusive multi producer, single consumer queue (Vyukov):
+// - push is wait-free and may be called from any thread
+// - pop must only be called from the consumer thread
+// - pop may return nullptr while a concurrent push is still linking its node, the
+//   producer has to wake up the consumer after pushing anyway
+// - nodes are owned by the caller and must outlive their stay in the queue
+class mpsc_queue
+{
+  std::atomic<mpsc_node *> head_; // last pushed node, producers side
+  mpsc_node *tail_;               // next node to pop, consumer side
+  mpsc_node stub_;
+
+public:
+  mpsc_queue() : head_(&stub_), tail_(&stub_) {}
+
+  mpsc_queue(const mpsc_queue &) = delete;
+  mpsc_queue &operator=(const mpsc_queue &) = delete;
+
+  void push(mpsc_node *node)
+  {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    auto prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  mpsc_node *pop()
+  {
+    auto tail = tail_;
+    auto next = tail->next.load(std::memory_order_acquire);
+
+    // skip stub
+    if (tail == &stub_)
+    {
+      if (next == nullptr)
+      {
+        return nullptr;
+      }
+      tail_ = next;
+      tail = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr)
+    {
+      tail_ = next;
+      return tail;
+    }
+
+    // a producer is about to link its node
+    if (tail != head_.load(std::memory_order_acquire))
+    {
+      return nullptr;
+    }
+
+    // tail is the last node, put the stub behind it so it can be handed out
+    push(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr)
+    {
+      tail_ = next;
+      return tail;
+    }
+    return nullptr;
+  }
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single writer, many readers snapshot of a trivially copyable value:
+// - the writer bumps the sequence to odd, copies the value, and bumps it to even again
+// - readers copy the value and retry while the sequence was odd or changed meanwhile
+// - the value is stored as relaxed atomic words, so torn reads are discarded instead of being data races
+template <typename T>
+class seqlock
+{
+  static_assert(std::is_trivially_copyable<T>::value, "seqlock values need to be trivially copyable");
+
+  static constexpr std::size_t word_count = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  std::atomic<uint32_t> sequence_{0};
+  std::atomic<uint64_t> words_[word_count]{};
+
+public:
+  // must not be called concurrently, in audience the writer is always the main thread
+  void store(const T &value)
+  {
+    uint64_t buffer[word_count]{};
+    std::memcpy(buffer, &value, sizeof(T));
+
+    auto sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < word_count; ++i)
+    {
+      words_[i].store(buffer[i], std::memory_order_relaxed);
+    }
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  T load() const
+  {
+    uint64_t buffer[word_count];
+    uint32_t before, after;
+    do
+    {
+      before = sequence_.load(std::memory_order_acquire);
+      for (std::size_t i = 0; i < word_count; ++i)
+      {
+        buffer[i] = words_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence_.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+
+    T value;
+    std::memcpy(&value, buffer, sizeof(T));
+    return value;
+  }
+
+  // true once a value got stored
+  bool valid() const
+  {
+    return sequence_.load(std::memory_order_acquire) >= 2;
+  }
+};
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <optional>
+#include <functional>
+#include <algorithm>
+#include <unordered_map>
+#include <type_traits>
+
+// key extractors for the reverse index of slot_map
+struct slot_map_no_key
+{
+  template <typename T>
+  int operator()(const T &) const { return 0; }
+};
+
+struct slot_map_identity_key
+{
+  template <typename T>
+  const T &operator()(const T &value) const { return value; }
+};
+
+// Dense storage addressed by 16-bit handles:
+// - the lower index_bits of a handle select the slot, the upper bits carry the generation of the slot
+// - a slot's generation advances when it is released, so stale handles of closed windows do not resolve
+// - the generation never becomes zero, so zero is never a valid handle
+// - released slots are reused only once all slots were handed out, oldest first, so a handle value comes
+//   back only after (generations x free slots) allocations instead of after one generation cycle of a slot
+// - KeyOf optionally maintains a reverse index from a key of the values to their handles, values with
+//   a default constructed key (e.g. null pointers) are not indexed
+template <typename T, unsigned index_bits = 8, typename KeyOf = slot_map_no_key>
+class slot_map
+{
+  static_assert(index_bits > 0 && index_bits < 16, "index bits must leave room for a generation");
+
+  static constexpr uint16_t index_mask = (1u << index_bits) - 1;
+  static constexpr uint16_t generation_limit = 1u << (16 - index_bits);
+  static constexpr bool indexed = !std::is_same<KeyOf, slot_map_no_key>::value;
+
+  typedef std::decay_t<decltype(KeyOf{}(std::declval<const T &>()))> key_type;
+
+  struct slot
+  {
+    uint16_t generation = 1;
+    std::optional<T> value;
+  };
+
+  std::vector<slot> slots_;
+  std::deque<uint16_t> free_; // released slots, each at most once
+  std::unordered_map<key_type, uint16_t> index_;
+  std::size_t size_ = 0;
+
+  static uint16_t make_handle(uint16_t index, uint16_t generation)
+  {
+    return static_cast<uint16_t>((generation << index_bits) | index);
+  }
+
+  slot *resolve(uint16_t handle)
+  {
+    std::size_t index = handle & index_mask;
+    if (index >= slots_.size())
+    {
+      return nullptr;
+    }
+    auto &s = slots_[index];
+    return s.value && make_handle(static_cast<uint16_t>(index), s.generation) == handle ? &s : nullptr;
+  }
+
+  void index_add(const T &value, uint16_t handle)
+  {
+    if constexpr (indexed)
+    {
+      auto key = KeyOf{}(value);
+      if (key != key_type{})
+      {
+        index_[key] = handle;
+      }
+    }
+  }
+
+  void index_remove(const T &value, uint16_t handle)
+  {
+    if constexpr (indexed)
+    {
+      auto ii = index_.find(KeyOf{}(value));
+      if (ii != index_.end() && ii->second == handle)
+      {
+        index_.erase(ii);
+      }
+    }
+  }
+
+public:
+  static constexpr std::size_t capacity = index_mask + 1;
+
+  // allocates a handle, zero if all slots are in use
+  uint16_t insert(T value)
+  {
+    uint16_t index;
+    if (slots_.size() < capacity)
+    {
+      index = static_cast<uint16_t>(slots_.size());
+      slots_.emplace_back();
+    }
+    else if (!free_.empty())
+    {
+      index = free_.front();
+      free_.pop_front();
+    }
+    else
+    {
+      return 0;
+    }
+
+    slots_[index].value.emplace(std::move(value));
+    size_ += 1;
+    auto handle = make_handle(index, slots_[index].generation);
+    index_add(*slots_[index].value, handle);
+    return handle;
+  }
+
+  // adopts a handle allocated by another slot map (e.g. the one of the nucleus)
+  bool insert_at(uint16_t handle, T value)
+  {
+    std::size_t index = handle & index_mask;
+    auto generation = static_cast<uint16_t>(handle >> index_bits);
+    if (handle == 0 || generation == 0)
+    {
+      return false;
+    }
+    while (slots_.size() <= index)
+    {
+      slots_.emplace_back();
+    }
+    auto &s = slots_[index];
+    if (s.value)
+    {
+      index_remove(*s.value, make_handle(static_cast<uint16_t>(index), s.generation));
+    }
+    else
+    {
+      // the slot is taken now, it must not be handed out by insert as well
+      auto ifree = std::find(free_.begin(), free_.end(), static_cast<uint16_t>(index));
+      if (ifree != free_.end())
+      {
+        free_.erase(ifree);
+      }
+      size_ += 1;
+    }
+    s.generation = generation;
+    s.value.emplace(std::move(value));
+    index_add(*s.value, handle);
+    return true;
+  }
+
+  T *find(uint16_t handle)
+  {
+    auto s = resolve(handle);
+    return s != nullptr ? &*s->value : nullptr;
+  }
+
+  // reverse lookup by scanning, zero if not found
+  template <typename Predicate>
+  uint16_t find_handle_if(Predicate predicate)
+  {
+    for (std::size_t index = 0; index < slots_.size(); ++index)
+    {
+      auto &s = slots_[index];
+      if (s.value && predicate(*s.value))
+      {
+        return make_handle(static_cast<uint16_t>(index), s.generation);
+      }
+    }
+    return 0;
+  }
+
+  // reverse lookup through the index, zero if not found
+  uint16_t find_handle(const key_type &key)
+  {
+    static_assert(indexed, "find_handle requires a key extractor");
+    auto ii = index_.find(key);
+    return ii != index_.end() ? ii->second : 0;
+  }
+
+  bool erase(uint16_t handle)
+  {
+    auto s = resolve(handle);
+    if (s == nullptr)
+    {
+      return false;
+    }
+    index_remove(*s->value, handle);
+    s->value.reset();
+    s->generation = s->generation + 1 < generation_limit ? s->generation + 1 : 1;
+    free_.push_back(handle & index_mask);
+    size_ -= 1;
+    return true;
+  }
+
+  // calls fn(handle, value) for all occupied slots in index order
+  template <typename Fn>
+  void for_each(Fn fn)
+  {
+    for (std::size_t index = 0; index < slots_.size(); ++index)
+    {
+      auto &s = slots_[index];
+      if (s.value)
+      {
+        fn(make_handle(static_cast<uint16_t>(index), s.generation), *s.value);
+      }
+    }
+  }
+
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+  bool empty() const
+  {
+    return size_ == 0;
+  }
+};
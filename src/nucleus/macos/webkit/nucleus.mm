@@ -387,3 +387,17 @@ void nucleus_impl_dispatch_async(void (*task)(void *context), void *context) {
     SPDLOG_WARN("we cannot dispatch task on main queue (async)");
   }
 }
+
+void nucleus_impl_dispatch_after(uint32_t delay_ms, void (*task)(void *context),
+                                 void *context) {
+  if (!is_terminating.load()) {
+    SPDLOG_TRACE("dispatching task on main queue (after {} ms)", delay_ms);
+    dispatch_after(
+        dispatch_time(DISPATCH_TIME_NOW, (int64_t)delay_ms * NSEC_PER_MSEC),
+        dispatch_get_main_queue(), ^{
+          task(context);
+        });
+  } else {
+    SPDLOG_WARN("we cannot dispatch task on main queue (after)");
+  }
+}
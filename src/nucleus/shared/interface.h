@@ -4,13 +4,15 @@
 #include <windows.h>
 #endif
 #include <wchar.h>
+#include <cstring>
 #include <string>
-#include <boost/bimap.hpp>
 #include <spdlog/spdlog.h>
 
 #include <audience_details.h>
 
-#include "../../../common/logger.h"
+#include "../../common/logger.h"
+#include "../../common/slot_map.h"
+#include "../../common/seqlock.h"
 #include "../../shared/nucleus_api_details.h"
 #include "safefn.h"
 #include "nucleus.h"
@@ -19,7 +21,9 @@
 // External Declaration
 ///////////////////////////////////////////////////////////////////////
 
-#ifdef WIN32
+#ifdef AUDIENCE_STATIC_NUCLEUS
+#define NUCLEUS_EXPORT
+#elif WIN32
 #define NUCLEUS_EXPORT __declspec(dllexport)
 #else
 #define NUCLEUS_EXPORT __attribute__((visibility("default")))
@@ -38,6 +42,12 @@ extern "C"
   NUCLEUS_EXPORT void nucleus_main();
   NUCLEUS_EXPORT void nucleus_dispatch_sync(void (*task)(void *context), void *context);
   NUCLEUS_EXPORT void nucleus_dispatch_async(void (*task)(void *context), void *context);
+  NUCLEUS_EXPORT void nucleus_dispatch_after(uint32_t delay_ms, void (*task)(void *context), void *context);
+  // optional, implemented by nuclei which can be driven by a foreign event loop (see NUCLEUS_PUBIMPL_EMBEDDED_LOOP)
+  NUCLEUS_EXPORT int nucleus_event_fd();
+  NUCLEUS_EXPORT int nucleus_poll(int timeout_ms);
+  // optional, implemented by nuclei which animate windows by themselves (see NUCLEUS_PUBIMPL_WINDOW_ANIMATE)
+  NUCLEUS_EXPORT void nucleus_window_animate(AudienceWindowHandle handle, AudienceRect target, uint32_t duration_ms, AudienceEasing easing);
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -50,6 +60,7 @@ extern "C"
 struct NucleusImplAppDetails
 {
   std::vector<std::wstring> icon_set;
+  uint8_t webview_pool_size;
 };
 
 struct NucleusImplWindowDetails
@@ -84,31 +95,75 @@ void nucleus_impl_quit();
 void nucleus_impl_main();
 void nucleus_impl_dispatch_sync(void (*task)(void *context), void *context);
 void nucleus_impl_dispatch_async(void (*task)(void *context), void *context);
+void nucleus_impl_dispatch_after(uint32_t delay_ms, void (*task)(void *context), void *context);
+int nucleus_impl_event_fd();
+int nucleus_impl_poll(int timeout_ms);
+void nucleus_impl_window_animate(AudienceWindowContext context, AudienceRect target, uint32_t duration_ms, AudienceEasing easing);
 
 ///////////////////////////////////////////////////////////////////////
 // Internal State
 ///////////////////////////////////////////////////////////////////////
 
-typedef boost::bimap<AudienceWindowHandle, AudienceWindowContext> NucleusWindowContextMap;
+// handles are allocated here and adopted by the shell, a handle of a closed window does not resolve again
+// (indexed by context, events of a window look up its handle)
+typedef slot_map<AudienceWindowContext, 8, slot_map_identity_key> NucleusWindowContextMap;
 extern NucleusWindowContextMap nucleus_window_context_map;
-extern AudienceWindowHandle nucleus_window_context_next_handle;
 
 extern AudienceNucleusProtocolNegotiation *nucleus_protocol_negotiation;
 
+// maintained by nuclei which set nucleus_publishes_geometry, see emit_screens_changed() and emit_windows_changed()
+extern seqlock<AudienceScreenList> nucleus_screen_snapshot;
+extern seqlock<AudienceWindowList> nucleus_window_snapshot;
+extern AudienceWindowList nucleus_window_reported; // last window list reported to the shell, main thread only
+
 ///////////////////////////////////////////////////////////////////////
 // Utils
 ///////////////////////////////////////////////////////////////////////
 
 static inline bool util_is_only_window(AudienceWindowContext context)
 {
-  return nucleus_window_context_map.size() == 1 && nucleus_window_context_map.right.find(context) != nucleus_window_context_map.right.end();
+  return nucleus_window_context_map.size() == 1 && nucleus_window_context_map.find_handle(context) != AudienceWindowHandle{};
+}
+
+static inline AudienceWindowList util_collect_window_list()
+{
+  AudienceWindowList result{};
+
+  result.focused = -1;
+
+  nucleus_window_context_map.for_each([&](AudienceWindowHandle handle, AudienceWindowContext &context) {
+    if (result.count >= AUDIENCE_WINDOW_LIST_ENTRIES)
+    {
+      return;
+    }
+
+    auto status = nucleus_impl_window_status(context);
+
+    if (status.has_focus)
+    {
+      result.focused = result.count;
+    }
+
+    result.windows[result.count].handle = handle;
+    result.windows[result.count].frame = status.frame;
+    result.windows[result.count].workspace = status.workspace;
+
+    result.count += 1;
+  });
+
+  return result;
+}
+
+static inline bool util_publishes_geometry()
+{
+  return nucleus_protocol_negotiation != nullptr && nucleus_protocol_negotiation->nucleus_publishes_geometry;
 }
 
 static inline bool util_destroy_all_windows()
 {
   SPDLOG_DEBUG("destroy all windows");
   std::vector<std::pair<AudienceWindowHandle, AudienceWindowContext>> context_list;
-  std::transform(nucleus_window_context_map.left.begin(), nucleus_window_context_map.left.end(), std::back_inserter(context_list), [](auto &pair) { return std::pair<AudienceWindowHandle, AudienceWindowContext>{pair.first, pair.second}; });
+  nucleus_window_context_map.for_each([&](AudienceWindowHandle handle, AudienceWindowContext &context) { context_list.emplace_back(handle, context); });
   for (auto &context : context_list)
   {
     SPDLOG_TRACE("destroy window with handle {}", context.first);
@@ -121,6 +176,8 @@ static inline bool util_destroy_all_windows()
 // Bridge Implementation
 ///////////////////////////////////////////////////////////////////////
 
+static inline void emit_windows_changed();
+
 static inline bool bridge_init(const char *nucleus_name, AudienceNucleusProtocolNegotiation *negotiation, const AudienceNucleusAppDetails *details)
 {
   // setup logger
@@ -138,43 +195,33 @@ static inline bool bridge_init(const char *nucleus_name, AudienceNucleusProtocol
     }
   }
 
+  impl_details.webview_pool_size = details->webview_pool_size;
+
   // init
   auto status = nucleus_impl_init(*negotiation, impl_details);
   if (status)
   {
     nucleus_protocol_negotiation = negotiation;
+
+    // initial geometry snapshot, later on kept up to date by events
+    if (util_publishes_geometry())
+    {
+      nucleus_screen_snapshot.store(nucleus_impl_screen_list());
+      nucleus_window_reported = util_collect_window_list();
+      nucleus_window_snapshot.store(nucleus_window_reported);
+    }
   }
   return status;
 }
 
-static inline AudienceWindowList bridge_window_list()
+static inline AudienceScreenList bridge_screen_list()
 {
-  AudienceWindowList result{};
-
-  result.focused = -1;
-
-  for (auto &entry : nucleus_window_context_map.left)
-  {
-    if (result.count >= AUDIENCE_WINDOW_LIST_ENTRIES)
-    {
-      break;
-    }
-
-    auto status = nucleus_impl_window_status(entry.second);
-
-    if (status.has_focus)
-    {
-      result.focused = result.count;
-    }
-
-    result.windows[result.count].handle = entry.first;
-    result.windows[result.count].frame = status.frame;
-    result.windows[result.count].workspace = status.workspace;
-
-    result.count += 1;
-  }
+  return util_publishes_geometry() ? nucleus_screen_snapshot.load() : nucleus_impl_screen_list();
+}
 
-  return result;
+static inline AudienceWindowList bridge_window_list()
+{
+  return util_publishes_geometry() ? nucleus_window_snapshot.load() : util_collect_window_list();
 }
 
 static inline AudienceWindowHandle bridge_window_create(const AudienceWindowDetails *details)
@@ -183,8 +230,8 @@ static inline AudienceWindowHandle bridge_window_create(const AudienceWindowDeta
   // TO BE IMPLEMENTED:
   // auto i_modal_parent_context =
   //     details->modal_parent != AudienceWindowHandle{}
-  //         ? nucleus_window_context_map.left.find(details->modal_parent)
-  //         : nucleus_window_context_map.left.end();
+  //         ? nucleus_window_context_map.find(details->modal_parent)
+  //         : nullptr;
 
   // translate details
   NucleusImplWindowDetails impl_details{
@@ -194,8 +241,8 @@ static inline AudienceWindowHandle bridge_window_create(const AudienceWindowDeta
       details->position,
       details->styles,
       // TO BE IMPLEMENTED:
-      // i_modal_parent_context != nucleus_window_context_map.left.end()
-      //     ? i_modal_parent_context->second
+      // i_modal_parent_context != nullptr
+      //     ? *i_modal_parent_context
       //     : AudienceWindowContext{},
       details->dev_mode};
 
@@ -207,29 +254,35 @@ static inline AudienceWindowHandle bridge_window_create(const AudienceWindowDeta
     return AudienceWindowHandle{};
   }
 
-  // allocate handle (we use defined overflow behaviour from unsigned data type here)
-  auto handle = nucleus_window_context_next_handle++;
-  while (nucleus_window_context_map.left.find(handle) != nucleus_window_context_map.left.end() || handle == AudienceWindowHandle{})
+  // allocate handle and add context to map
+  auto handle = nucleus_window_context_map.insert(context);
+  if (handle == AudienceWindowHandle{})
   {
-    handle = nucleus_window_context_next_handle++;
+    SPDLOG_ERROR("too many windows, at most {} windows can exist concurrently", NucleusWindowContextMap::capacity);
+    nucleus_impl_window_destroy(context);
+    return AudienceWindowHandle{};
   }
-
-  // add context to map
-  nucleus_window_context_map.insert(NucleusWindowContextMap::value_type(handle, context));
   SPDLOG_INFO("window context and associated handle added to map");
 
+  // publish right away, but report the initial geometry once the shell adopted the handle
+  if (util_publishes_geometry())
+  {
+    nucleus_window_snapshot.store(util_collect_window_list());
+    nucleus_impl_dispatch_async([](void *) { emit_windows_changed(); }, nullptr);
+  }
+
   return handle;
 }
 
 static inline void bridge_window_update_position(AudienceWindowHandle handle, AudienceRect position)
 {
   // find context
-  auto icontext = nucleus_window_context_map.left.find(handle);
+  auto icontext = nucleus_window_context_map.find(handle);
 
   // update window position
-  if (icontext != nucleus_window_context_map.left.end())
+  if (icontext != nullptr)
   {
-    return nucleus_impl_window_update_position(icontext->second, position);
+    return nucleus_impl_window_update_position(*icontext, position);
   }
   else
   {
@@ -241,12 +294,12 @@ static inline void bridge_window_update_position(AudienceWindowHandle handle, Au
 static inline void bridge_window_post_message(AudienceWindowHandle handle, const wchar_t *message)
 {
   // find context
-  auto icontext = nucleus_window_context_map.left.find(handle);
+  auto icontext = nucleus_window_context_map.find(handle);
 
   // post message
-  if (icontext != nucleus_window_context_map.left.end())
+  if (icontext != nullptr)
   {
-    return nucleus_impl_window_post_message(icontext->second, std::wstring(message));
+    return nucleus_impl_window_post_message(*icontext, std::wstring(message));
   }
   else
   {
@@ -258,12 +311,29 @@ static inline void bridge_window_post_message(AudienceWindowHandle handle, const
 static inline void bridge_window_destroy(AudienceWindowHandle handle)
 {
   // find context
-  auto icontext = nucleus_window_context_map.left.find(handle);
+  auto icontext = nucleus_window_context_map.find(handle);
 
   // destroy window
-  if (icontext != nucleus_window_context_map.left.end())
+  if (icontext != nullptr)
   {
-    return nucleus_impl_window_destroy(icontext->second);
+    return nucleus_impl_window_destroy(*icontext);
+  }
+  else
+  {
+    SPDLOG_WARN("window handle/context not found, window and its context already destroyed");
+    return;
+  }
+}
+
+static inline void bridge_window_animate(AudienceWindowHandle handle, AudienceRect target, uint32_t duration_ms, AudienceEasing easing)
+{
+  // find context
+  auto icontext = nucleus_window_context_map.find(handle);
+
+  // start animation, replaces a running one silently
+  if (icontext != nullptr)
+  {
+    return nucleus_impl_window_animate(*icontext, target, duration_ms, easing);
   }
   else
   {
@@ -282,17 +352,97 @@ static inline void bridge_quit()
 // Event Handling
 ///////////////////////////////////////////////////////////////////////
 
-static inline void emit_unsafe_window_message(AudienceWindowContext context, const std::wstring &message)
+static inline void emit_unsafe_screens_changed()
+{
+  if (util_publishes_geometry())
+  {
+    SPDLOG_TRACE("publishing screen list");
+    nucleus_screen_snapshot.store(nucleus_impl_screen_list());
+  }
+}
+
+// to be called on the main thread whenever monitors get added, removed or reconfigured, or focus moves between screens
+static inline void emit_screens_changed()
+{
+  return NUCLEUS_SAFE_FN(emit_unsafe_screens_changed)();
+}
+
+static inline void emit_unsafe_windows_changed()
+{
+  if (!util_publishes_geometry())
+  {
+    return;
+  }
+
+  // publish first, so handlers see the new state when querying the window list
+  auto previous = nucleus_window_reported;
+  auto current = util_collect_window_list();
+  SPDLOG_TRACE("publishing window list");
+  nucleus_window_snapshot.store(current);
+  nucleus_window_reported = current;
+
+  // report differences to the shell, new windows report their initial geometry as well
+  auto &window_level = nucleus_protocol_negotiation->shell_event_handler.window_level;
+  for (uint8_t i = 0; i < current.count; ++i)
+  {
+    auto &window = current.windows[i];
+    int found = -1;
+    for (uint8_t j = 0; j < previous.count && found < 0; ++j)
+    {
+      found = previous.windows[j].handle == window.handle ? j : -1;
+    }
+
+    auto frame_changed = found < 0 || std::memcmp(&previous.windows[found].frame, &window.frame, sizeof(AudienceRect)) != 0;
+    auto workspace_changed = found < 0 || std::memcmp(&previous.windows[found].workspace, &window.workspace, sizeof(AudienceSize)) != 0;
+    if ((frame_changed || workspace_changed) && window_level.on_geometry_change != nullptr)
+    {
+      window_level.on_geometry_change(window.handle, window.frame, window.workspace);
+    }
+
+    auto had_focus = found >= 0 && previous.focused == found;
+    auto has_focus = current.focused == i;
+    if (had_focus != has_focus && window_level.on_focus_change != nullptr)
+    {
+      window_level.on_focus_change(window.handle, has_focus);
+    }
+  }
+}
+
+// to be called on the main thread whenever windows get moved, resized or focused, creation and closing is handled here;
+// nuclei should coalesce bursts of native events (e.g. during interactive resizing) to one call per frame
+static inline void emit_windows_changed()
+{
+  return NUCLEUS_SAFE_FN(emit_unsafe_windows_changed)();
+}
+
+static inline void emit_unsafe_window_animation_complete(AudienceWindowContext context)
 {
   // lookup handle
-  auto ihandle = nucleus_window_context_map.right.find(context);
-  if (ihandle == nucleus_window_context_map.right.end())
+  auto handle = nucleus_window_context_map.find_handle(context);
+  if (handle == AudienceWindowHandle{})
   {
     SPDLOG_WARN("window handle/context not found, window and its context already destroyed");
     return;
   }
 
-  auto handle = ihandle->second;
+  // call shell handler
+  nucleus_protocol_negotiation->shell_event_handler.window_level.on_animation_complete(handle);
+}
+
+static inline void emit_window_animation_complete(AudienceWindowContext context)
+{
+  return NUCLEUS_SAFE_FN(emit_unsafe_window_animation_complete)(context);
+}
+
+static inline void emit_unsafe_window_message(AudienceWindowContext context, const std::wstring &message)
+{
+  // lookup handle
+  auto handle = nucleus_window_context_map.find_handle(context);
+  if (handle == AudienceWindowHandle{})
+  {
+    SPDLOG_WARN("window handle/context not found, window and its context already destroyed");
+    return;
+  }
 
   // call shell handler
   nucleus_protocol_negotiation->shell_event_handler.window_level.on_message(handle, message.c_str());
@@ -306,15 +456,13 @@ static inline void emit_window_message(AudienceWindowContext context, const std:
 static inline void emit_unsafe_window_close_intent(AudienceWindowContext context)
 {
   // lookup handle
-  auto ihandle = nucleus_window_context_map.right.find(context);
-  if (ihandle == nucleus_window_context_map.right.end())
+  auto handle = nucleus_window_context_map.find_handle(context);
+  if (handle == AudienceWindowHandle{})
   {
     SPDLOG_WARN("window handle/context not found, window and its context already destroyed");
     return;
   }
 
-  auto handle = ihandle->second;
-
   // call shell handler
   nucleus_protocol_negotiation->shell_event_handler.window_level.on_close_intent(handle);
 }
@@ -327,21 +475,20 @@ static inline void emit_window_close_intent(AudienceWindowContext context)
 static inline void emit_unsafe_window_close(AudienceWindowContext context, bool is_last_window)
 {
   // lookup handle
-  auto ihandle = nucleus_window_context_map.right.find(context);
-  if (ihandle == nucleus_window_context_map.right.end())
+  auto handle = nucleus_window_context_map.find_handle(context);
+  if (handle == AudienceWindowHandle{})
   {
     SPDLOG_WARN("window handle/context not found, window and its context already destroyed");
     return;
   }
 
-  auto handle = ihandle->second;
-
   // call shell handler
   nucleus_protocol_negotiation->shell_event_handler.window_level.on_close(handle, is_last_window);
 
   // remove window from context map
-  nucleus_window_context_map.right.erase(context);
+  nucleus_window_context_map.erase(handle);
   SPDLOG_INFO("window context and associated handle removed from map");
+  emit_windows_changed();
 }
 
 static inline void emit_window_close(AudienceWindowContext context, bool is_last_window)
@@ -384,7 +531,7 @@ static inline void emit_app_quit()
   {                                                                                            \
     NUCLEUS_RELEASEPOOL                                                                        \
     {                                                                                          \
-      return NUCLEUS_SAFE_FN(nucleus_impl_screen_list, SAFE_FN_DEFAULT(AudienceScreenList))(); \
+      return NUCLEUS_SAFE_FN(bridge_screen_list, SAFE_FN_DEFAULT(AudienceScreenList))();       \
     }                                                                                          \
   }
 
@@ -469,10 +616,49 @@ static inline void emit_app_quit()
     }                                                                     \
   }
 
+#define NUCLEUS_PUBIMPL_DISPATCH_AFTER                                                       \
+  void nucleus_dispatch_after(uint32_t delay_ms, void (*task)(void *context), void *context) \
+  {                                                                                          \
+    NUCLEUS_RELEASEPOOL                                                                      \
+    {                                                                                        \
+      return NUCLEUS_SAFE_FN(nucleus_impl_dispatch_after)(delay_ms, task, context);          \
+    }                                                                                        \
+  }
+
+// -1 signals "no event fd" and "no timeout pending" to the shell
+static int nucleus_embedded_loop_none = -1;
+
+#define NUCLEUS_PUBIMPL_EMBEDDED_LOOP                                                      \
+  int nucleus_event_fd()                                                                   \
+  {                                                                                        \
+    NUCLEUS_RELEASEPOOL                                                                    \
+    {                                                                                      \
+      return NUCLEUS_SAFE_FN(nucleus_impl_event_fd, &nucleus_embedded_loop_none)();        \
+    }                                                                                      \
+  }                                                                                        \
+  int nucleus_poll(int timeout_ms)                                                         \
+  {                                                                                        \
+    NUCLEUS_RELEASEPOOL                                                                    \
+    {                                                                                      \
+      return NUCLEUS_SAFE_FN(nucleus_impl_poll, &nucleus_embedded_loop_none)(timeout_ms); \
+    }                                                                                      \
+  }
+
+#define NUCLEUS_PUBIMPL_WINDOW_ANIMATE                                                                                    \
+  void nucleus_window_animate(AudienceWindowHandle handle, AudienceRect target, uint32_t duration_ms, AudienceEasing easing) \
+  {                                                                                                                         \
+    NUCLEUS_RELEASEPOOL                                                                                                     \
+    {                                                                                                                       \
+      return NUCLEUS_SAFE_FN(bridge_window_animate)(handle, target, duration_ms, easing);                                  \
+    }                                                                                                                       \
+  }
+
 #define NUCLEUS_PUBIMPL(nucleus_name)                                                     \
-  boost::bimap<AudienceWindowHandle, AudienceWindowContext> nucleus_window_context_map{}; \
-  AudienceWindowHandle nucleus_window_context_next_handle = AudienceWindowHandle{};       \
+  NucleusWindowContextMap nucleus_window_context_map{};                                   \
   AudienceNucleusProtocolNegotiation *nucleus_protocol_negotiation = nullptr;             \
+  seqlock<AudienceScreenList> nucleus_screen_snapshot{};                                  \
+  seqlock<AudienceWindowList> nucleus_window_snapshot{};                                  \
+  AudienceWindowList nucleus_window_reported{};                                           \
   NUCLEUS_PUBIMPL_INIT(nucleus_name);                                                     \
   NUCLEUS_PUBIMPL_SCREEN_LIST;                                                            \
   NUCLEUS_PUBIMPL_WINDOW_LIST;                                                            \
@@ -483,4 +669,5 @@ static inline void emit_app_quit()
   NUCLEUS_PUBIMPL_QUIT;                                                                   \
   NUCLEUS_PUBIMPL_MAIN;                                                                   \
   NUCLEUS_PUBIMPL_DISPATCH_SYNC;                                                          \
-  NUCLEUS_PUBIMPL_DISPATCH_ASYNC;
+  NUCLEUS_PUBIMPL_DISPATCH_ASYNC;                                                         \
+  NUCLEUS_PUBIMPL_DISPATCH_AFTER;
@@ -1,2 +1,4 @@
 #include "../../shared/interface.h"
 NUCLEUS_PUBIMPL("unix.webkit")
+NUCLEUS_PUBIMPL_EMBEDDED_LOOP
+NUCLEUS_PUBIMPL_WINDOW_ANIMATE
@@ -7,10 +7,23 @@
 #include <mutex>
 #include <condition_variable>
 #include <cmath>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <unistd.h>
+#include <fcntl.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
 #include <spdlog/spdlog.h>
 
 #include "../../../common/scope_guard.h"
 #include "../../../common/utf.h"
+#include "../../../common/easing.h"
+#include "../../../common/mpsc_queue.h"
 #include "../../shared/interface.h"
 #include "nucleus.h"
 
@@ -19,15 +32,184 @@
 void window_resize_callback(GtkWidget *widget, GdkRectangle *allocation, gpointer user_data);
 gboolean window_close_callback(GtkWidget *widget, GdkEvent *event, gpointer user_data);
 void window_destroy_callback(GtkWidget *widget, gpointer arg);
+void window_release(AudienceWindowContext *context_priv);
+static void webview_pool_schedule_fill();
 void webview_title_update_callback(GtkWidget *widget, gpointer arg);
+gboolean window_configure_callback(GtkWidget *widget, GdkEvent *event, gpointer user_data);
+void schedule_windows_changed();
+void window_focus_callback(GtkWidget *widget, GParamSpec *pspec, gpointer user_data);
+void screen_monitors_changed_callback(GdkScreen *screen, gpointer user_data);
+void display_monitor_callback(GdkDisplay *display, GdkMonitor *monitor, gpointer user_data);
 
 static gboolean window_close_callback_default_return = TRUE;
+static gboolean window_configure_callback_default_return = FALSE;
+static bool windows_changed_scheduled = false;
+
+// warm windows with webviews, hidden and without context until handed out by nucleus_impl_window_create()
+struct WebviewPoolEntry
+{
+  GtkWidget *window;
+  GtkWidget *webview;
+};
+static std::vector<WebviewPoolEntry> webview_pool{};
+static size_t webview_pool_size = 0;
+static bool webview_pool_fill_scheduled = false;
 static std::atomic<bool> is_terminating = false;
 
+// state of the glib main context while it is driven by nucleus_impl_poll() instead of gtk_main()
+static struct
+{
+  bool active = false;
+  bool prepared = false;
+  bool quit = false;
+  bool quit_emitted = false;
+  int epoll_fd = -1;
+  gint max_priority = 0;
+  gint timeout = -1;
+  std::vector<GPollFD> fds{};
+  std::map<int, uint32_t> registered{};
+} embedded_loop;
+
+// Tasks dispatched from other threads are queued lock-free and drained by a single
+// main loop source per wakeup. Sync and async tasks share one queue, so tasks of a
+// thread run in the order they got dispatched, and the queue yields to redraws and
+// input after a batch.
+struct NucleusTask : mpsc_node
+{
+  void (*task)(void *context);
+  void *context;
+  bool sync;                      // sync tasks are signaled instead of deleted
+  std::atomic<uint32_t> state{0}; // 1 once a sync task completed
+#ifndef __linux__
+  std::mutex mutex; // no futex, the waiter of a sync task blocks on the condition
+  std::condition_variable completed;
+#endif
+};
+
+static constexpr size_t task_source_batch = 64;
+
+static struct
+{
+  mpsc_queue tasks;
+  std::atomic<bool> wakeup_pending{false};
+  int wakeup_fd = -1;       // eventfd, or read end of a pipe
+  int wakeup_write_fd = -1; // same as wakeup_fd for eventfd
+  GSource *source = nullptr;
+} task_source;
+
+static void task_source_wakeup()
+{
+  // one wakeup per drain, further producers only enqueue
+  if (task_source.wakeup_pending.exchange(true, std::memory_order_acq_rel))
+  {
+    return;
+  }
+#ifdef __linux__
+  uint64_t one = 1;
+  auto written = write(task_source.wakeup_write_fd, &one, sizeof(one));
+#else
+  char one = 1;
+  auto written = write(task_source.wakeup_write_fd, &one, sizeof(one));
+#endif
+  (void)written;
+}
+
+static void task_source_push(NucleusTask *node)
+{
+  task_source.tasks.push(node);
+  task_source_wakeup();
+}
+
+static void task_source_run(NucleusTask *node)
+{
+  node->task(node->context);
+  if (node->sync)
+  {
+#ifdef __linux__
+    node->state.store(1, std::memory_order_release);
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&node->state), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+    // notify under the lock, the waiter owns the node and may release it right after
+    std::lock_guard<std::mutex> lock(node->mutex);
+    node->state.store(1, std::memory_order_release);
+    node->completed.notify_one();
+#endif
+  }
+  else
+  {
+    delete node;
+  }
+}
+
+static gboolean task_source_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
+{
+  // reset wakeup before draining, pushes from now on trigger another one
+#ifdef __linux__
+  uint64_t counter;
+#else
+  char counter[64];
+#endif
+  while (read(task_source.wakeup_fd, &counter, sizeof(counter)) > 0)
+  {
+  }
+  task_source.wakeup_pending.exchange(false, std::memory_order_acq_rel);
+
+  for (size_t i = 0; i < task_source_batch; ++i)
+  {
+    auto node = task_source.tasks.pop();
+    if (node == nullptr)
+    {
+      return G_SOURCE_CONTINUE;
+    }
+    task_source_run(static_cast<NucleusTask *>(node));
+  }
+
+  // batch exhausted, continue in the next iteration of the main loop
+  task_source_wakeup();
+  return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs task_source_funcs = {nullptr, nullptr, task_source_dispatch, nullptr};
+
+static bool task_source_attach()
+{
+#ifdef __linux__
+  task_source.wakeup_fd = task_source.wakeup_write_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (task_source.wakeup_fd < 0)
+  {
+    SPDLOG_ERROR("eventfd() failed");
+    return false;
+  }
+#else
+  int fds[2];
+  if (pipe(fds) != 0)
+  {
+    SPDLOG_ERROR("pipe() failed");
+    return false;
+  }
+  for (auto fd : fds)
+  {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+  task_source.wakeup_fd = fds[0];
+  task_source.wakeup_write_fd = fds[1];
+#endif
+
+  // same priority as the idle sources used before, so tasks still run ahead of redraws
+  task_source.source = g_source_new(&task_source_funcs, sizeof(GSource));
+  g_source_set_priority(task_source.source, G_PRIORITY_HIGH_IDLE);
+  g_source_set_name(task_source.source, "audience task queue");
+  g_source_add_unix_fd(task_source.source, task_source.wakeup_fd, G_IO_IN);
+  g_source_attach(task_source.source, nullptr);
+  return true;
+}
+
 bool nucleus_impl_init(AudienceNucleusProtocolNegotiation &negotiation, const NucleusImplAppDetails &details)
 {
   // negotiate protocol
   negotiation.nucleus_handles_webapp_type_url = true;
+  negotiation.nucleus_publishes_geometry = true;
 
   // init gtk
   if (gtk_init_check(0, NULL) == FALSE)
@@ -36,6 +218,12 @@ bool nucleus_impl_init(AudienceNucleusProtocolNegotiation &negotiation, const Nu
     return false;
   }
 
+  // main queue for tasks of other threads
+  if (!task_source_attach())
+  {
+    return false;
+  }
+
   // load icons
   // NOTE: GDK/X11 (and maybe other implementations) too stops packing icons silently,
   //       once a certain limit is hit. For that reason it seems best to order icons
@@ -77,6 +265,19 @@ bool nucleus_impl_init(AudienceNucleusProtocolNegotiation &negotiation, const Nu
     gtk_window_set_default_icon_list(icon_list);
   }
 
+  // keep geometry snapshot up to date, monitor-added/removed only exist since gtk 3.22
+  auto display = gdk_display_get_default();
+  g_signal_connect(G_OBJECT(gdk_display_get_default_screen(display)), "monitors-changed", G_CALLBACK(NUCLEUS_SAFE_FN(screen_monitors_changed_callback)), nullptr);
+  if (g_signal_lookup("monitor-added", G_OBJECT_TYPE(display)) != 0)
+  {
+    g_signal_connect(G_OBJECT(display), "monitor-added", G_CALLBACK(NUCLEUS_SAFE_FN(display_monitor_callback)), nullptr);
+    g_signal_connect(G_OBJECT(display), "monitor-removed", G_CALLBACK(NUCLEUS_SAFE_FN(display_monitor_callback)), nullptr);
+  }
+
+  // prewarm webviews
+  webview_pool_size = details.webview_pool_size;
+  webview_pool_schedule_fill();
+
   SPDLOG_INFO("initialized");
   return true;
 }
@@ -163,6 +364,86 @@ AudienceScreenList nucleus_impl_screen_list()
   return result;
 }
 
+static GtkWidget *webview_create(WebKitWebView *related)
+{
+  // related web views share the web process of the given one
+  auto webview = related != nullptr ? webkit_web_view_new_with_related_view(related) : webkit_web_view_new();
+  if (webview != nullptr)
+  {
+    g_signal_connect(G_OBJECT(webview), "notify::title", G_CALLBACK(NUCLEUS_SAFE_FN(webview_title_update_callback)), nullptr);
+  }
+  return webview;
+}
+
+static WebviewPoolEntry webview_pair_create()
+{
+  // create window
+  auto window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+
+  if (window == nullptr)
+  {
+    throw std::runtime_error("could not create window");
+  }
+
+  // create webview
+  auto webview = webview_create(nullptr);
+
+  if (webview == nullptr)
+  {
+    gtk_widget_destroy(window);
+    throw std::runtime_error("could not create webview");
+  }
+
+  gtk_container_add(GTK_CONTAINER(window), GTK_WIDGET(webview));
+
+  // listen to destroy signal and title changed event (handlers ignore widgets without context, e.g. pooled ones)
+  g_signal_connect(G_OBJECT(window), "size-allocate", G_CALLBACK(NUCLEUS_SAFE_FN(window_resize_callback)), nullptr);
+  g_signal_connect(G_OBJECT(window), "delete-event", G_CALLBACK(NUCLEUS_SAFE_FN(window_close_callback, &window_close_callback_default_return)), nullptr);
+  g_signal_connect(G_OBJECT(window), "destroy", G_CALLBACK(NUCLEUS_SAFE_FN(window_destroy_callback)), nullptr);
+  g_signal_connect_after(G_OBJECT(window), "configure-event", G_CALLBACK(NUCLEUS_SAFE_FN(window_configure_callback, &window_configure_callback_default_return)), nullptr);
+  g_signal_connect(G_OBJECT(window), "notify::has-toplevel-focus", G_CALLBACK(NUCLEUS_SAFE_FN(window_focus_callback)), nullptr);
+
+  return WebviewPoolEntry{window, webview};
+}
+
+static void webview_pool_schedule_fill()
+{
+  if (webview_pool_fill_scheduled || webview_pool.size() >= webview_pool_size)
+  {
+    return;
+  }
+  webview_pool_fill_scheduled = true;
+
+  // one pair per main loop iteration, at low priority, so windows in use stay responsive
+  g_idle_add_full(
+      G_PRIORITY_LOW,
+      [](void *) -> gboolean {
+        if (is_terminating.load() || webview_pool.size() >= webview_pool_size)
+        {
+          webview_pool_fill_scheduled = false;
+          return G_SOURCE_REMOVE;
+        }
+        try
+        {
+          auto pair = webview_pair_create();
+          // spawns the web process
+          webkit_web_view_load_uri(WEBKIT_WEB_VIEW(pair.webview), "about:blank");
+          gtk_widget_show(GTK_WIDGET(pair.webview));
+          webview_pool.push_back(pair);
+          SPDLOG_DEBUG("webview pool filled to {} of {}", webview_pool.size(), webview_pool_size);
+        }
+        catch (const std::exception &e)
+        {
+          SPDLOG_ERROR("could not fill webview pool: {}", e.what());
+          webview_pool_fill_scheduled = false;
+          return G_SOURCE_REMOVE;
+        }
+        return G_SOURCE_CONTINUE;
+      },
+      nullptr,
+      nullptr);
+}
+
 AudienceWindowContext nucleus_impl_window_create(const NucleusImplWindowDetails &details)
 {
   scope_guard scope_fail(scope_guard::execution::exception);
@@ -193,13 +474,22 @@ AudienceWindowContext nucleus_impl_window_create(const NucleusImplWindowDetails
 #pragma GCC diagnostic pop
   }
 
-  // create window
-  context->window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
-
-  if (context->window == nullptr)
+  // take warm window and webview from pool or create them
+  auto pooled = !webview_pool.empty();
+  WebviewPoolEntry pair{};
+  if (pooled)
   {
-    throw std::runtime_error("could not create window");
+    pair = webview_pool.back();
+    webview_pool.pop_back();
+    webview_pool_schedule_fill();
+    SPDLOG_DEBUG("window taken from webview pool, {} left", webview_pool.size());
   }
+  else
+  {
+    pair = webview_pair_create();
+  }
+  context->window = pair.window;
+  context->webview = pair.webview;
 
   scope_fail += [context]() {
     if (context->window != nullptr)
@@ -214,51 +504,29 @@ AudienceWindowContext nucleus_impl_window_create(const NucleusImplWindowDetails
   gtk_window_set_resizable(GTK_WINDOW(context->window), true);
   gtk_window_set_position(GTK_WINDOW(context->window), GTK_WIN_POS_CENTER);
 
-  // create webview
-  context->webview = webkit_web_view_new();
-
-  if (context->webview == nullptr)
+  // pooled windows were shown before, default size and position do not apply again
+  if (pooled)
   {
-    throw std::runtime_error("could not create webview");
+    gtk_widget_set_size_request(GTK_WIDGET(context->window), -1, -1);
+    gtk_window_resize(GTK_WINDOW(context->window), workarea.width / 2, workarea.height / 2);
+    gtk_window_move(GTK_WINDOW(context->window), workarea.x + workarea.width / 4, workarea.y + workarea.height / 4);
   }
 
-  gtk_container_add(GTK_CONTAINER(context->window), GTK_WIDGET(context->webview));
-
   // create context instance for window and widget
   auto context_priv = new AudienceWindowContext(context);
   g_object_set_data(G_OBJECT(context->window), WIDGET_HANDLE_KEY, context_priv);
   g_object_set_data(G_OBJECT(context->webview), WIDGET_HANDLE_KEY, context_priv);
 
-  // listen to destroy signal and title changed event
-  g_signal_connect(G_OBJECT(context->window), "size-allocate", G_CALLBACK(NUCLEUS_SAFE_FN(window_resize_callback)), nullptr);
-  g_signal_connect(G_OBJECT(context->window), "delete-event", G_CALLBACK(NUCLEUS_SAFE_FN(window_close_callback, &window_close_callback_default_return)), nullptr);
-  g_signal_connect(G_OBJECT(context->window), "destroy", G_CALLBACK(NUCLEUS_SAFE_FN(window_destroy_callback)), nullptr);
-  g_signal_connect(G_OBJECT(context->webview), "notify::title", G_CALLBACK(NUCLEUS_SAFE_FN(webview_title_update_callback)), nullptr);
-
-  // debugging features
-  if (details.dev_mode)
-  {
-    WebKitSettings *settings =
-        webkit_web_view_get_settings(WEBKIT_WEB_VIEW(context->webview));
-    webkit_settings_set_enable_write_console_messages_to_stdout(settings, true);
-    webkit_settings_set_enable_developer_extras(settings, true);
-  }
+  // debugging features (set both ways, pooled webviews keep settings of their previous use)
+  WebKitSettings *settings =
+      webkit_web_view_get_settings(WEBKIT_WEB_VIEW(context->webview));
+  webkit_settings_set_enable_write_console_messages_to_stdout(settings, details.dev_mode);
+  webkit_settings_set_enable_developer_extras(settings, details.dev_mode);
 
   // set window styles
-  if (details.styles.not_decorated)
-  {
-    gtk_window_set_decorated(GTK_WINDOW(context->window), FALSE);
-  }
-
-  if (details.styles.not_resizable)
-  {
-    gtk_window_set_resizable(GTK_WINDOW(context->window), FALSE);
-  }
-
-  if (details.styles.always_on_top)
-  {
-    gtk_window_set_keep_above(GTK_WINDOW(context->window), TRUE);
-  }
+  gtk_window_set_decorated(GTK_WINDOW(context->window), !details.styles.not_decorated);
+  gtk_window_set_resizable(GTK_WINDOW(context->window), !details.styles.not_resizable);
+  gtk_window_set_keep_above(GTK_WINDOW(context->window), details.styles.always_on_top);
 
   // position window
   if (details.position.size.width > 0 && details.position.size.height > 0)
@@ -298,11 +566,32 @@ nucleus_impl_window_status(AudienceWindowContext context)
   return result;
 }
 
+static void window_animation_stop(AudienceWindowContext context)
+{
+  if (context->animation_tick_id != 0)
+  {
+    if (context->window != nullptr)
+    {
+      gtk_widget_remove_tick_callback(GTK_WIDGET(context->window), context->animation_tick_id);
+    }
+    context->animation_tick_id = 0;
+  }
+}
+
+static void window_apply_position(AudienceWindowContext context, AudienceRect position);
+
 void nucleus_impl_window_update_position(AudienceWindowContext context,
                                          AudienceRect position)
 {
   SPDLOG_DEBUG("window_update_position: origin={},{} size={}x{}", position.origin.x, position.origin.y, position.size.width, position.size.height);
 
+  // explicit positioning wins over a running animation
+  window_animation_stop(context);
+  window_apply_position(context, position);
+}
+
+static void window_apply_position(AudienceWindowContext context, AudienceRect position)
+{
   // write positioning info to context
   context->last_positioning = std::chrono::steady_clock::now();
   context->last_positioning_data = position;
@@ -323,6 +612,105 @@ void nucleus_impl_window_update_position(AudienceWindowContext context,
 
 void nucleus_impl_window_post_message(AudienceWindowContext context, const std::wstring &message) {}
 
+void nucleus_impl_window_animate(AudienceWindowContext context, AudienceRect target, uint32_t duration_ms, AudienceEasing easing)
+{
+  SPDLOG_DEBUG("window_animate: origin={},{} size={}x{} duration={}ms", target.origin.x, target.origin.y, target.size.width, target.size.height, duration_ms);
+
+  window_animation_stop(context);
+
+  if (duration_ms == 0)
+  {
+    window_apply_position(context, target);
+    emit_window_animation_complete(context);
+    return;
+  }
+
+  // start from the current frame
+  gint wx = 0, wy = 0, ww = 0, wh = 0;
+  gtk_window_get_position(GTK_WINDOW(context->window), &wx, &wy);
+  gtk_window_get_size(GTK_WINDOW(context->window), &ww, &wh);
+
+  context->animation_from = {{(double)wx, (double)wy}, {(double)ww, (double)wh}};
+  context->animation_to = target;
+  context->animation_start = 0;
+  context->animation_duration = gint64(duration_ms) * 1000;
+  context->animation_easing = easing;
+
+  // one step per frame of the window's frame clock
+  context->animation_tick_id = gtk_widget_add_tick_callback(
+      GTK_WIDGET(context->window),
+      [](GtkWidget *widget, GdkFrameClock *frame_clock, gpointer context_void) -> gboolean {
+        auto context = *static_cast<AudienceWindowContext *>(context_void);
+        auto now = gdk_frame_clock_get_frame_time(frame_clock);
+        if (context->animation_start == 0)
+        {
+          context->animation_start = now;
+        }
+
+        auto t = double(now - context->animation_start) / double(context->animation_duration);
+        if (t < 1.0)
+        {
+          window_apply_position(context, easing_interpolate(context->animation_from, context->animation_to, context->animation_easing, t));
+          return G_SOURCE_CONTINUE;
+        }
+
+        window_apply_position(context, context->animation_to);
+        context->animation_tick_id = 0;
+        emit_window_animation_complete(context);
+        return G_SOURCE_REMOVE;
+      },
+      new AudienceWindowContext(context),
+      [](gpointer context_void) {
+        delete static_cast<AudienceWindowContext *>(context_void);
+      });
+}
+
+static bool webview_pool_recycle(AudienceWindowContext context)
+{
+  if (is_terminating.load() || webview_pool.size() >= webview_pool_size || context->webview == nullptr)
+  {
+    return false;
+  }
+
+  auto context_priv = reinterpret_cast<AudienceWindowContext *>(g_object_get_data(G_OBJECT(context->window), WIDGET_HANDLE_KEY));
+  if (context_priv == nullptr)
+  {
+    return false;
+  }
+
+  // the back/forward list cannot be cleared, so the web view gets replaced by a fresh one, which keeps
+  // the web process warm but starts without history, zoom or page state
+  auto webview = webview_create(WEBKIT_WEB_VIEW(context->webview));
+  if (webview == nullptr)
+  {
+    return false;
+  }
+
+  // close window like a destroy would do, but keep the window
+  WebviewPoolEntry pair{context->window, context->webview};
+  window_animation_stop(context);
+  gtk_widget_hide(GTK_WIDGET(pair.window));
+  window_release(context_priv);
+
+  // reset window state of previous use
+  gtk_window_unmaximize(GTK_WINDOW(pair.window));
+  gtk_window_unfullscreen(GTK_WINDOW(pair.window));
+  gtk_window_deiconify(GTK_WINDOW(pair.window));
+  gtk_window_set_title(GTK_WINDOW(pair.window), "");
+
+  // swap web views, the container holds the only reference to the old one
+  webkit_web_view_stop_loading(WEBKIT_WEB_VIEW(pair.webview));
+  gtk_container_remove(GTK_CONTAINER(pair.window), GTK_WIDGET(pair.webview));
+  gtk_container_add(GTK_CONTAINER(pair.window), webview);
+  webkit_web_view_load_uri(WEBKIT_WEB_VIEW(webview), "about:blank");
+  gtk_widget_show(webview);
+  pair.webview = webview;
+
+  webview_pool.push_back(pair);
+  SPDLOG_INFO("window returned to webview pool, {} of {}", webview_pool.size(), webview_pool_size);
+  return true;
+}
+
 void nucleus_impl_window_destroy(AudienceWindowContext context)
 {
   SPDLOG_TRACE("delaying call to gtk_widget_destroy()");
@@ -330,7 +718,7 @@ void nucleus_impl_window_destroy(AudienceWindowContext context)
       G_PRIORITY_HIGH_IDLE,
       [](void *context_void) {
         AudienceWindowContext *context = reinterpret_cast<AudienceWindowContext *>(context_void);
-        if ((*context)->window != nullptr)
+        if ((*context)->window != nullptr && !webview_pool_recycle(*context))
         {
           SPDLOG_INFO("calling gtk_widget_destroy()");
           gtk_widget_destroy(GTK_WIDGET((*context)->window));
@@ -366,6 +754,12 @@ void nucleus_impl_quit()
         SPDLOG_INFO("top level windows: {}", window_count);
         if (window_count == 0)
         {
+          if (embedded_loop.active)
+          {
+            SPDLOG_INFO("leaving embedded event loop");
+            embedded_loop.quit = true;
+            return FALSE;
+          }
           SPDLOG_INFO("calling gtk_main_quit()");
           gtk_main_quit();
           return FALSE;
@@ -387,6 +781,163 @@ void nucleus_impl_main()
   exit(0);
 }
 
+static void embedded_loop_sync_epoll()
+{
+#ifdef __linux__
+  if (embedded_loop.epoll_fd < 0)
+  {
+    return;
+  }
+
+  // collect wanted events per fd, glib may poll a single fd more than once
+  std::map<int, uint32_t> wanted;
+  for (auto &pfd : embedded_loop.fds)
+  {
+    uint32_t events = 0;
+    events |= (pfd.events & G_IO_IN) ? EPOLLIN : 0;
+    events |= (pfd.events & G_IO_OUT) ? EPOLLOUT : 0;
+    events |= (pfd.events & G_IO_PRI) ? EPOLLPRI : 0;
+    wanted[pfd.fd] |= events;
+  }
+
+  for (auto ir = embedded_loop.registered.begin(); ir != embedded_loop.registered.end();)
+  {
+    if (wanted.find(ir->first) == wanted.end())
+    {
+      epoll_ctl(embedded_loop.epoll_fd, EPOLL_CTL_DEL, ir->first, nullptr);
+      ir = embedded_loop.registered.erase(ir);
+    }
+    else
+    {
+      ++ir;
+    }
+  }
+
+  for (auto &iw : wanted)
+  {
+    epoll_event event{};
+    event.events = iw.second;
+    event.data.fd = iw.first;
+    auto ir = embedded_loop.registered.find(iw.first);
+    if (ir == embedded_loop.registered.end())
+    {
+      if (epoll_ctl(embedded_loop.epoll_fd, EPOLL_CTL_ADD, iw.first, &event) == 0)
+      {
+        embedded_loop.registered[iw.first] = iw.second;
+      }
+      else
+      {
+        SPDLOG_WARN("could not add fd {} to embedded event loop", iw.first);
+      }
+    }
+    else if (ir->second != iw.second)
+    {
+      epoll_ctl(embedded_loop.epoll_fd, EPOLL_CTL_MOD, iw.first, &event);
+      ir->second = iw.second;
+    }
+  }
+#endif
+}
+
+static void embedded_loop_prepare()
+{
+  auto context = g_main_context_default();
+
+  g_main_context_prepare(context, &embedded_loop.max_priority);
+
+  embedded_loop.fds.resize(std::max<size_t>(embedded_loop.fds.size(), 16));
+  gint fd_count;
+  while ((fd_count = g_main_context_query(context, embedded_loop.max_priority, &embedded_loop.timeout, embedded_loop.fds.data(), (gint)embedded_loop.fds.size())) > (gint)embedded_loop.fds.size())
+  {
+    embedded_loop.fds.resize(fd_count);
+  }
+  embedded_loop.fds.resize(fd_count);
+
+  embedded_loop_sync_epoll();
+  embedded_loop.prepared = true;
+}
+
+static bool embedded_loop_start()
+{
+  if (!embedded_loop.active)
+  {
+    if (!g_main_context_acquire(g_main_context_default()))
+    {
+      SPDLOG_ERROR("main context is owned by another thread");
+      return false;
+    }
+    SPDLOG_INFO("entering embedded event loop");
+    embedded_loop.active = true;
+  }
+  return true;
+}
+
+int nucleus_impl_event_fd()
+{
+#ifdef __linux__
+  if (!embedded_loop_start())
+  {
+    return -1;
+  }
+  if (embedded_loop.epoll_fd < 0)
+  {
+    embedded_loop.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (embedded_loop.epoll_fd < 0)
+    {
+      SPDLOG_ERROR("epoll_create1() failed");
+      return -1;
+    }
+    embedded_loop.prepared = false;
+  }
+  if (!embedded_loop.prepared)
+  {
+    embedded_loop_prepare();
+  }
+  return embedded_loop.epoll_fd;
+#else
+  return -1;
+#endif
+}
+
+int nucleus_impl_poll(int timeout_ms)
+{
+  if (embedded_loop.quit_emitted || !embedded_loop_start())
+  {
+    return -1;
+  }
+
+  if (!embedded_loop.prepared)
+  {
+    embedded_loop_prepare();
+  }
+
+  // wait no longer than glib and the caller allow
+  auto timeout = embedded_loop.timeout;
+  if (timeout < 0 || (timeout_ms >= 0 && timeout_ms < timeout))
+  {
+    timeout = timeout_ms;
+  }
+  g_poll(embedded_loop.fds.data(), (guint)embedded_loop.fds.size(), timeout);
+
+  auto context = g_main_context_default();
+  if (g_main_context_check(context, embedded_loop.max_priority, embedded_loop.fds.data(), (gint)embedded_loop.fds.size()))
+  {
+    g_main_context_dispatch(context);
+  }
+  embedded_loop.prepared = false;
+
+  // trigger final event, the host application decides on its own when to exit
+  if (embedded_loop.quit)
+  {
+    embedded_loop.quit_emitted = true;
+    emit_app_quit();
+    return -1;
+  }
+
+  embedded_loop_prepare();
+  return embedded_loop.timeout;
+}
+
 void nucleus_impl_dispatch_sync(void (*task)(void *context), void *context)
 {
   if (is_terminating.load())
@@ -396,34 +947,25 @@ void nucleus_impl_dispatch_sync(void (*task)(void *context), void *context)
     return;
   }
 
-  // sync utilities
-  bool ready = false;
-  std::condition_variable condition;
-  std::mutex mutex;
-
-  // prepare wrapper
-  auto wrapper_lambda = [&]() {
-    // execute task
-    task(context);
-    // set ready signal
-    std::unique_lock<std::mutex> ready_lock(mutex);
-    ready = true;
-    ready_lock.unlock();
-    condition.notify_one();
-  };
-
-  auto wrapper = [](void *context) {
-    (*static_cast<decltype(wrapper_lambda) *>(context))();
-    return FALSE;
-  };
+  // node lives on our stack, we wait for its completion anyway
+  NucleusTask node{};
+  node.task = task;
+  node.context = context;
+  node.sync = true;
 
-  // execute wrapper
-  SPDLOG_INFO("dispatching task on main queue (sync)");
-  gdk_threads_add_idle_full(G_PRIORITY_HIGH_IDLE, wrapper, &wrapper_lambda, nullptr);
+  SPDLOG_TRACE("dispatching task on main queue (sync)");
+  task_source_push(&node);
 
   // wait for ready signal
-  std::unique_lock<std::mutex> wait_lock(mutex);
-  condition.wait(wait_lock, [&] { return ready; });
+#ifdef __linux__
+  while (node.state.load(std::memory_order_acquire) == 0)
+  {
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&node.state), FUTEX_WAIT_PRIVATE, 0, nullptr, nullptr, 0);
+  }
+#else
+  std::unique_lock<std::mutex> lock(node.mutex);
+  node.completed.wait(lock, [&node] { return node.state.load(std::memory_order_acquire) != 0; });
+#endif
 }
 
 void nucleus_impl_dispatch_async(void (*task)(void *context), void *context)
@@ -434,15 +976,32 @@ void nucleus_impl_dispatch_async(void (*task)(void *context), void *context)
     return;
   }
 
+  auto node = new NucleusTask{};
+  node->task = task;
+  node->context = context;
+
+  SPDLOG_TRACE("dispatching task on main queue (async)");
+  task_source_push(node);
+}
+
+void nucleus_impl_dispatch_after(uint32_t delay_ms, void (*task)(void *context), void *context)
+{
+  if (is_terminating.load())
+  {
+    SPDLOG_WARN("we cannot dispatch task on main queue (after)");
+    return;
+  }
+
   struct wrapped_context_t
   {
     void (*task)(void *context);
     void *context;
   };
 
-  SPDLOG_INFO("dispatching task on main queue (async)");
-  gdk_threads_add_idle_full(
-      G_PRIORITY_HIGH_IDLE,
+  SPDLOG_TRACE("dispatching task on main queue (after {} ms)", delay_ms);
+  gdk_threads_add_timeout_full(
+      G_PRIORITY_DEFAULT,
+      delay_ms,
       [](void *wrapped_context_void) {
         auto wrapped_context = static_cast<wrapped_context_t *>(wrapped_context_void);
         wrapped_context->task(wrapped_context->context);
@@ -469,9 +1028,63 @@ void window_resize_callback(GtkWidget *widget, GdkRectangle *allocation, gpointe
           (gint)std::ceil((*context_priv)->last_positioning_data.origin.x),
           (gint)std::ceil((*context_priv)->last_positioning_data.origin.y));
     }
+
+    // workspace follows allocation of the webview
+    schedule_windows_changed();
   }
 }
 
+void schedule_windows_changed()
+{
+  // interactive moves and resizes fire configure and allocate events in bursts, publish them once per frame
+  if (windows_changed_scheduled)
+  {
+    return;
+  }
+  windows_changed_scheduled = true;
+  gdk_threads_add_timeout_full(
+      G_PRIORITY_DEFAULT,
+      1000 / 60,
+      [](void *) {
+        windows_changed_scheduled = false;
+        emit_windows_changed();
+        return FALSE;
+      },
+      nullptr,
+      nullptr);
+}
+
+gboolean window_configure_callback(GtkWidget *widget, GdkEvent *event, gpointer user_data)
+{
+  if (g_object_get_data(G_OBJECT(widget), WIDGET_HANDLE_KEY) != nullptr)
+  {
+    schedule_windows_changed();
+  }
+  return FALSE;
+}
+
+void window_focus_callback(GtkWidget *widget, GParamSpec *pspec, gpointer user_data)
+{
+  if (g_object_get_data(G_OBJECT(widget), WIDGET_HANDLE_KEY) != nullptr)
+  {
+    // focused screen follows the focused window
+    schedule_windows_changed();
+    emit_screens_changed();
+  }
+}
+
+void screen_monitors_changed_callback(GdkScreen *screen, gpointer user_data)
+{
+  SPDLOG_DEBUG("monitors changed");
+  emit_screens_changed();
+}
+
+void display_monitor_callback(GdkDisplay *display, GdkMonitor *monitor, gpointer user_data)
+{
+  SPDLOG_DEBUG("monitor added or removed");
+  emit_screens_changed();
+}
+
 gboolean window_close_callback(GtkWidget *widget, GdkEvent *event, gpointer user_data)
 {
   // trigger event
@@ -493,26 +1106,33 @@ void window_destroy_callback(GtkWidget *widget, gpointer arg)
   auto context_priv = reinterpret_cast<AudienceWindowContext *>(g_object_get_data(G_OBJECT(widget), WIDGET_HANDLE_KEY));
   if (context_priv != nullptr)
   {
-    // trigger event
-    emit_window_close(*context_priv, util_is_only_window(*context_priv));
+    // tick callbacks die with the widget
+    (*context_priv)->animation_tick_id = 0;
+    window_release(context_priv);
+  }
+}
 
-    // remove context pointer from widgets
-    if ((*context_priv)->window != nullptr)
-    {
-      g_object_set_data(G_OBJECT((*context_priv)->window), WIDGET_HANDLE_KEY, nullptr);
-      (*context_priv)->window = nullptr;
-    }
+void window_release(AudienceWindowContext *context_priv)
+{
+  // trigger event
+  emit_window_close(*context_priv, util_is_only_window(*context_priv));
 
-    if ((*context_priv)->webview)
-    {
-      g_object_set_data(G_OBJECT((*context_priv)->webview), WIDGET_HANDLE_KEY, nullptr);
-      (*context_priv)->webview = nullptr;
-    }
+  // remove context pointer from widgets
+  if ((*context_priv)->window != nullptr)
+  {
+    g_object_set_data(G_OBJECT((*context_priv)->window), WIDGET_HANDLE_KEY, nullptr);
+    (*context_priv)->window = nullptr;
+  }
 
-    // discard private context
-    delete context_priv;
-    SPDLOG_INFO("window closed and private context released");
+  if ((*context_priv)->webview)
+  {
+    g_object_set_data(G_OBJECT((*context_priv)->webview), WIDGET_HANDLE_KEY, nullptr);
+    (*context_priv)->webview = nullptr;
   }
+
+  // discard private context
+  delete context_priv;
+  SPDLOG_INFO("window closed and private context released");
 }
 
 void webview_title_update_callback(GtkWidget *widget, gpointer arg)
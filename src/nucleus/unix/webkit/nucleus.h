@@ -13,10 +13,24 @@ struct AudienceWindowContextData
   std::chrono::time_point<std::chrono::steady_clock> last_positioning; // programatically, not by user...
   AudienceRect last_positioning_data;
 
+  // running animation, driven by the frame clock of the window
+  guint animation_tick_id;
+  gint64 animation_start; // frame time in microseconds, zero until the first frame
+  gint64 animation_duration;
+  AudienceRect animation_from;
+  AudienceRect animation_to;
+  AudienceEasing animation_easing;
+
   AudienceWindowContextData() : window(nullptr),
                                 webview(nullptr),
                                 last_positioning{},
-                                last_positioning_data{}
+                                last_positioning_data{},
+                                animation_tick_id(0),
+                                animation_start(0),
+                                animation_duration(0),
+                                animation_from{},
+                                animation_to{},
+                                animation_easing(AUDIENCE_EASING_LINEAR)
   {
   }
 };
@@ -5,6 +5,7 @@
 #include <winrt/Windows.Web.UI.Interop.h>
 
 #include <memory>
+#include <map>
 #include <atomic>
 #include <spdlog/spdlog.h>
 
@@ -36,6 +37,10 @@ void UpdateWebViewPosition(const AudienceWindowContext context);
 
 std::atomic<HWND> _audience_message_window = nullptr;
 
+// delayed tasks by timer id of the message window (timer id 1 is reserved for quitting)
+std::map<UINT_PTR, std::pair<void (*)(void *), void *>> _audience_delayed_tasks;
+UINT_PTR _audience_delayed_tasks_next_id = 0x100;
+
 // void dpi_convert(double &width, double &height)
 // {
 //   auto monitor_handle = MonitorFromPoint({0, 0}, MONITOR_DEFAULTTOPRIMARY);
@@ -466,6 +471,18 @@ void nucleus_impl_dispatch_async(void (*task)(void *context), void *context)
   PostMessageW(_audience_message_window.load(), WM_AUDIENCE_DISPATCH, (WPARAM)task, (LPARAM)context);
 }
 
+void nucleus_impl_dispatch_after(uint32_t delay_ms, void (*task)(void *context), void *context)
+{
+  // NOTE: Timers of the message window are owned by the main thread, therefore this has to be called from there.
+  auto id = _audience_delayed_tasks_next_id++;
+  _audience_delayed_tasks[id] = {task, context};
+  if (SetTimer(_audience_message_window.load(), id, delay_ms, nullptr) == 0)
+  {
+    _audience_delayed_tasks.erase(id);
+    throw std::runtime_error("could not set timer");
+  }
+}
+
 LRESULT CALLBACK MessageWndProc(HWND window, UINT message, WPARAM wParam, LPARAM lParam)
 {
   // handle dispatched task
@@ -487,6 +504,14 @@ LRESULT CALLBACK MessageWndProc(HWND window, UINT message, WPARAM wParam, LPARAM
     delete context;
     return 0;
   }
+  else if (message == WM_TIMER && _audience_delayed_tasks.count(wParam) > 0)
+  {
+    KillTimer(window, wParam);
+    auto entry = _audience_delayed_tasks[wParam];
+    _audience_delayed_tasks.erase(wParam);
+    entry.first(entry.second);
+    return 0;
+  }
   else if (message == WM_TIMER && wParam == 1)
   {
     size_t window_count = 0;
@@ -1,5 +1,6 @@
 #include <windows.h>
 #include <memory>
+#include <map>
 #include <stdexcept>
 #include <mutex>
 #include <atomic>
@@ -26,6 +27,10 @@ LRESULT CALLBACK MessageWndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM l
 
 std::atomic<HWND> _audience_message_window = nullptr;
 
+// delayed tasks by timer id of the message window (timer id 1 is reserved for quitting)
+std::map<UINT_PTR, std::pair<void (*)(void *), void *>> _audience_delayed_tasks;
+UINT_PTR _audience_delayed_tasks_next_id = 0x100;
+
 bool nucleus_impl_init(AudienceNucleusProtocolNegotiation &negotiation, const NucleusImplAppDetails &details)
 {
   // negotiate protocol
@@ -410,6 +415,18 @@ void nucleus_impl_dispatch_async(void (*task)(void *context), void *context)
   PostMessageW(_audience_message_window.load(), WM_AUDIENCE_DISPATCH, (WPARAM)task, (LPARAM)context);
 }
 
+void nucleus_impl_dispatch_after(uint32_t delay_ms, void (*task)(void *context), void *context)
+{
+  // NOTE: Timers of the message window are owned by the main thread, therefore this has to be called from there.
+  auto id = _audience_delayed_tasks_next_id++;
+  _audience_delayed_tasks[id] = {task, context};
+  if (SetTimer(_audience_message_window.load(), id, delay_ms, nullptr) == 0)
+  {
+    _audience_delayed_tasks.erase(id);
+    throw std::runtime_error("could not set timer");
+  }
+}
+
 LRESULT CALLBACK MessageWndProc(HWND window, UINT message, WPARAM wParam, LPARAM lParam)
 {
   // handle dispatched task
@@ -431,6 +448,14 @@ LRESULT CALLBACK MessageWndProc(HWND window, UINT message, WPARAM wParam, LPARAM
     delete context;
     return 0;
   }
+  else if (message == WM_TIMER && _audience_delayed_tasks.count(wParam) > 0)
+  {
+    KillTimer(window, wParam);
+    auto entry = _audience_delayed_tasks[wParam];
+    _audience_delayed_tasks.erase(wParam);
+    entry.first(entry.second);
+    return 0;
+  }
   else if (message == WM_TIMER && wParam == 1)
   {
     size_t window_count = 0;
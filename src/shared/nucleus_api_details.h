@@ -10,6 +10,7 @@ struct AudienceNucleusProtocolNegotiation
   bool nucleus_handles_webapp_type_directory;
   bool nucleus_handles_webapp_type_url;
   bool nucleus_handles_messaging;
+  bool nucleus_publishes_geometry; // screen and window list may be called from any thread
   struct
   {
     struct
@@ -17,6 +18,9 @@ struct AudienceNucleusProtocolNegotiation
       void (*on_message)(AudienceWindowHandle handle, const wchar_t *message);
       void (*on_close_intent)(AudienceWindowHandle handle);
       void (*on_close)(AudienceWindowHandle handle, bool is_last_window);
+      void (*on_geometry_change)(AudienceWindowHandle handle, AudienceRect frame, AudienceSize workspace);
+      void (*on_focus_change)(AudienceWindowHandle handle, bool has_focus);
+      void (*on_animation_complete)(AudienceWindowHandle handle); // not called for interrupted animations
     } window_level;
     struct
     {
@@ -28,6 +32,7 @@ struct AudienceNucleusProtocolNegotiation
 typedef struct
 {
   const wchar_t *icon_set[AUDIENCE_APP_DETAILS_ICON_SET_ENTRIES];
+  uint8_t webview_pool_size;
 } AudienceNucleusAppDetails;
 
 #pragma pack(pop)
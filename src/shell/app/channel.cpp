@@ -7,6 +7,8 @@
 #include <set>
 #include <regex>
 #include <mutex>
+#include <algorithm>
+#include <iterator>
 #include <spdlog/spdlog.h>
 #include <json.hpp>
 
@@ -15,11 +17,13 @@
 #include "../../common/fmt_exception.h"
 #include "../../common/memory_scope.h"
 #include "../../common/utf.h"
+#include "../../common/base64.h"
 #include "channel.h"
 
 using json = nlohmann::json;
 
 static std::unique_ptr<std::thread> loop_thread; // can only be used from controlling thread
+static bool json_payload = false;                 // set before loop thread started, read-only afterwards
 
 static std::mutex mutex;                                        // protects the following variables (except before loop thread started):
 std::shared_ptr<uvw::Loop> loop;                                // can be used from controlling and from loop thread
@@ -49,10 +53,12 @@ static void _peer_on_error(const uvw::ErrorEvent &, uvw::PipeHandle &);       //
 
 static void _push_queues(); // called on loop thread only
 
-void channel_create(const std::string &path) // called on controlling thread
+void channel_create(const std::string &path, bool json_payload_mode) // called on controlling thread
 {
   SPDLOG_DEBUG("create channel: {}", path);
 
+  json_payload = json_payload_mode;
+
 #if defined(WIN32)
   if (!std::regex_match(path, std::regex(R"(^\\\\\.\\pipe\\[\w]+$)", std::regex::ECMAScript | std::regex::icase)))
   {
@@ -169,11 +175,8 @@ static void _push_queues()
   }
 }
 
-static void _channel_emit(std::string name, json data) // called on controlling or loop thread (applies to all emit function)
+static void _channel_emit_raw(const std::string &event) // called on controlling or loop thread (applies to all emit function)
 {
-  // serialize event json
-  auto event = json{{"name", name}, {"data", data}}.dump() + "\n";
-
   // prepare raw event data
   uvw::DataEvent event_raw(std::make_unique<char[]>(event.length()), event.length());
   std::copy(event.begin(), event.end(), event_raw.data.get());
@@ -189,9 +192,37 @@ static void _channel_emit(std::string name, json data) // called on controlling
   }
 }
 
-void channel_emit_window_message(AudienceWindowHandle handle, const wchar_t *message)
+static void _channel_emit(std::string name, json data)
+{
+  // serialize event json
+  _channel_emit_raw(json{{"name", name}, {"data", data}}.dump() + "\n");
+}
+
+void channel_emit_window_message(AudienceWindowHandle handle, const char *message, size_t length)
 {
-  _channel_emit("window_message", json{{"handle", handle}, {"message", utf16_to_utf8(message)}});
+  // splice messages which are valid json verbatim into the event, if enabled
+  if (json_payload && json::accept(message, message + length))
+  {
+    std::string event = "{\"name\":\"window_message\",\"data\":{\"handle\":" + std::to_string(handle) + ",\"payload\":";
+    event.reserve(event.size() + length + 3);
+    // line breaks can only occur as whitespace within valid json, but would break the line protocol
+    std::replace_copy_if(
+        message, message + length, std::back_inserter(event), [](char c) { return c == '\n' || c == '\r'; }, ' ');
+    event += "}}\n";
+    return _channel_emit_raw(event);
+  }
+
+  _channel_emit("window_message", json{{"handle", handle}, {"message", std::string(message, length)}});
+}
+
+void channel_emit_window_binary(AudienceWindowHandle handle, const void *data, size_t length)
+{
+  _channel_emit("window_binary", json{{"handle", handle}, {"data", base64_encode(data, length)}});
+}
+
+void channel_emit_window_resync(AudienceWindowHandle handle)
+{
+  _channel_emit("window_resync", json{{"handle", handle}});
 }
 
 void channel_emit_window_close_intent(AudienceWindowHandle handle)
@@ -204,6 +235,18 @@ void channel_emit_window_close(AudienceWindowHandle handle, bool is_last_window)
   _channel_emit("window_close", json{{"handle", handle}, {"is_last_window", is_last_window}});
 }
 
+void channel_emit_window_geometry_change(AudienceWindowHandle handle, AudienceRect frame, AudienceSize workspace)
+{
+  _channel_emit("window_geometry_change", json{{"handle", handle},
+                                               {"frame", {{"x", frame.origin.x}, {"y", frame.origin.y}, {"width", frame.size.width}, {"height", frame.size.height}}},
+                                               {"workspace", {{"width", workspace.width}, {"height", workspace.height}}}});
+}
+
+void channel_emit_window_focus_change(AudienceWindowHandle handle, bool has_focus)
+{
+  _channel_emit("window_focus_change", json{{"handle", handle}, {"has_focus", has_focus}});
+}
+
 void channel_emit_app_quit()
 {
   _channel_emit("app_quit", json{});
@@ -224,6 +267,12 @@ static void _channel_emit_command_failed(std::string id, const std::string &reas
   _channel_emit("command_failed", json{{"id", id}, {"reason", reason}});
 }
 
+static void _channel_emit_command_completed(AudienceWindowHandle, void *context)
+{
+  std::unique_ptr<std::string> id(static_cast<std::string *>(context));
+  _channel_emit_command_succeeded(*id);
+}
+
 static void _peer_execute_command(const uvw::DataEvent &command_raw)
 {
   try
@@ -379,9 +428,17 @@ static void _peer_execute_command(const uvw::DataEvent &command_raw)
 
         // construct window handler
         AudienceWindowEventHandler weh{};
-        weh.on_message.handler = [](AudienceWindowHandle handle, void *context, const wchar_t *message) {
+        weh.on_message_utf8.handler = [](AudienceWindowHandle handle, void *context, const char *message, size_t length) {
           SPDLOG_DEBUG("event window::message");
-          channel_emit_window_message(handle, message);
+          channel_emit_window_message(handle, message, length);
+        };
+        weh.on_binary.handler = [](AudienceWindowHandle handle, void *context, const void *data, size_t length) {
+          SPDLOG_DEBUG("event window::binary");
+          channel_emit_window_binary(handle, data, length);
+        };
+        weh.on_resync.handler = [](AudienceWindowHandle handle, void *context) {
+          SPDLOG_DEBUG("event window::resync");
+          channel_emit_window_resync(handle);
         };
         weh.on_close_intent.handler = [](AudienceWindowHandle handle, void *context) {
           SPDLOG_DEBUG("event window::close_intent");
@@ -391,15 +448,27 @@ static void _peer_execute_command(const uvw::DataEvent &command_raw)
           SPDLOG_DEBUG("event window::close");
           channel_emit_window_close(handle, is_last_window);
         };
+        weh.on_geometry_change.handler = [](AudienceWindowHandle handle, void *context, AudienceRect frame, AudienceSize workspace) {
+          SPDLOG_TRACE("event window::geometry_change");
+          channel_emit_window_geometry_change(handle, frame, workspace);
+        };
+        weh.on_focus_change.handler = [](AudienceWindowHandle handle, void *context, bool has_focus) {
+          SPDLOG_DEBUG("event window::focus_change");
+          channel_emit_window_focus_change(handle, has_focus);
+        };
 
-        // execute command
-        auto result = audience_window_create(&wd, &weh);
-        if (result == AudienceWindowHandle{})
-        {
-          throw std::runtime_error("could not create window");
-        }
-
-        _channel_emit_command_succeeded(id, json(result));
+        // execute command, several creations may be in flight
+        audience_window_create_async(
+            &wd, &weh, [](AudienceWindowHandle handle, void *context) {
+              std::unique_ptr<std::string> id(static_cast<std::string *>(context));
+              if (handle == AudienceWindowHandle{})
+              {
+                _channel_emit_command_failed(*id, "could not create window");
+                return;
+              }
+              _channel_emit_command_succeeded(*id, json(handle));
+            },
+            new std::string(id));
       }
       else if (func == "window_update_position")
       {
@@ -411,24 +480,148 @@ static void _peer_execute_command(const uvw::DataEvent &command_raw)
         position.size.width = args.at("width").get<double>();
         position.size.height = args.at("height").get<double>();
 
-        audience_window_update_position(handle, position);
-        _channel_emit_command_succeeded(id);
+        audience_window_update_position_async(handle, position, _channel_emit_command_completed, new std::string(id));
+      }
+      else if (func == "window_animate")
+      {
+        auto handle = args.at("handle").get<AudienceWindowHandle>();
+
+        AudienceRect target;
+        target.origin.x = args.at("x").get<double>();
+        target.origin.y = args.at("y").get<double>();
+        target.size.width = args.at("width").get<double>();
+        target.size.height = args.at("height").get<double>();
+
+        auto duration = args.at("duration").get<uint32_t>();
+
+        auto easing = AUDIENCE_EASING_LINEAR;
+        auto easing_name = args.count("easing") > 0 ? args["easing"].get<std::string>() : "linear";
+        if (easing_name == "ease_in")
+        {
+          easing = AUDIENCE_EASING_EASE_IN;
+        }
+        else if (easing_name == "ease_out")
+        {
+          easing = AUDIENCE_EASING_EASE_OUT;
+        }
+        else if (easing_name == "ease_in_out")
+        {
+          easing = AUDIENCE_EASING_EASE_IN_OUT;
+        }
+        else if (easing_name != "linear")
+        {
+          throw std::invalid_argument("unknown easing " + easing_name);
+        }
+
+        // succeeds once the animation ended, reports whether it ran to completion
+        audience_window_animate(
+            handle, target, duration, easing, [](AudienceWindowHandle handle, void *context, bool completed) {
+              std::unique_ptr<std::string> id(static_cast<std::string *>(context));
+              _channel_emit_command_succeeded(*id, json{{"completed", completed}});
+            },
+            new std::string(id));
       }
       else if (func == "window_post_message")
       {
         auto handle = args.at("handle").get<AudienceWindowHandle>();
-        auto message = utf8_to_utf16(args.at("message").get<std::string>());
 
-        audience_window_post_message(handle, message.c_str());
+        // json payloads are posted as their compact serialization, without an extra layer of string escaping
+        if (args.count("payload") > 0)
+        {
+          auto message = args.at("payload").dump();
+          audience_window_post_message_utf8(handle, message.data(), message.size());
+        }
+        else
+        {
+          auto &message = args.at("message").get_ref<const std::string &>();
+          audience_window_post_message_utf8(handle, message.data(), message.size());
+        }
         _channel_emit_command_succeeded(id);
       }
-      else if (func == "window_destroy")
+      else if (func == "batch")
+      {
+        auto &entries = args.at("messages");
+
+        std::vector<AudienceMessage> messages;
+        messages.reserve(entries.size());
+        for (auto &entry : entries)
+        {
+          auto &message = entry.at("message").get_ref<const std::string &>();
+          messages.push_back(AudienceMessage{entry.at("handle").get<AudienceWindowHandle>(), message.data(), message.size()});
+        }
+
+        AudienceMessageBatch batch{messages.data(), messages.size()};
+        audience_window_post_messages(&batch);
+        _channel_emit_command_succeeded(id);
+      }
+      else if (func == "window_post_binary")
+      {
+        auto handle = args.at("handle").get<AudienceWindowHandle>();
+        auto data = base64_decode(args.at("data").get<std::string>());
+
+        audience_window_post_binary(handle, data.data(), data.size());
+        _channel_emit_command_succeeded(id);
+      }
+      else if (func == "window_publish_blob")
+      {
+        auto handle = args.at("handle").get<AudienceWindowHandle>();
+        auto mime_type = args.value("mime_type", std::string("application/octet-stream"));
+
+        // the decoded buffer is owned by the blob until it gets revoked
+        auto data = new std::string(base64_decode(args.at("data").get<std::string>()));
+        AudienceBlobDetails details{};
+        details.data = data->data();
+        details.length = data->size();
+        details.mime_type = mime_type.c_str();
+        details.on_release.handler = [](void *context) { delete static_cast<std::string *>(context); };
+        details.on_release.context = data;
+
+        auto result = audience_window_publish_blob(handle, &details);
+        if (result.url[0] == 0)
+        {
+          throw std::runtime_error("could not publish blob");
+        }
+        _channel_emit_command_succeeded(id, json{{"url", result.url}});
+      }
+      else if (func == "window_revoke_blob")
+      {
+        auto handle = args.at("handle").get<AudienceWindowHandle>();
+        auto &url = args.at("url").get_ref<const std::string &>();
+
+        audience_window_revoke_blob(handle, url.c_str());
+        _channel_emit_command_succeeded(id);
+      }
+      else if (func == "state_set")
+      {
+        auto handle = args.at("handle").get<AudienceWindowHandle>();
+        auto &path = args.at("path").get_ref<const std::string &>();
+        auto value = args.at("value").dump();
+
+        audience_state_set(handle, path.c_str(), value.c_str());
+        _channel_emit_command_succeeded(id);
+      }
+      else if (func == "state_remove")
       {
         auto handle = args.at("handle").get<AudienceWindowHandle>();
+        auto &path = args.at("path").get_ref<const std::string &>();
+
+        audience_state_remove(handle, path.c_str());
+        _channel_emit_command_succeeded(id);
+      }
+      else if (func == "publish")
+      {
+        auto &topic = args.at("topic").get_ref<const std::string &>();
+        auto &message = args.at("message").get_ref<const std::string &>();
 
-        audience_window_destroy(handle);
+        audience_publish(topic.c_str(), message.data(), message.size());
         _channel_emit_command_succeeded(id);
       }
+      else if (func == "window_destroy")
+      {
+        auto handle = args.at("handle").get<AudienceWindowHandle>();
+
+        audience_window_destroy_async(handle, _channel_emit_command_completed, new std::string(id));
+      }
       else if (func == "quit")
       {
         audience_quit();
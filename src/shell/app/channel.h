@@ -3,11 +3,15 @@
 #include <string>
 #include <audience_details.h>
 
-extern void channel_create(const std::string& path);
+extern void channel_create(const std::string& path, bool json_payload);
 extern void channel_activate();
 extern void channel_shutdown();
 
-extern void channel_emit_window_message(AudienceWindowHandle handle, const wchar_t *message);
+extern void channel_emit_window_message(AudienceWindowHandle handle, const char *message, size_t length);
+extern void channel_emit_window_binary(AudienceWindowHandle handle, const void *data, size_t length);
+extern void channel_emit_window_resync(AudienceWindowHandle handle);
 extern void channel_emit_window_close_intent(AudienceWindowHandle handle);
 extern void channel_emit_window_close(AudienceWindowHandle handle, bool is_last_window);
+extern void channel_emit_window_geometry_change(AudienceWindowHandle handle, AudienceRect frame, AudienceSize workspace);
+extern void channel_emit_window_focus_change(AudienceWindowHandle handle, bool has_focus);
 extern void channel_emit_app_quit();
@@ -12,6 +12,8 @@
 #include <ctime>
 #include <sstream>
 #include <optional>
+#include <algorithm>
+#include <cstdint>
 #include <spdlog/spdlog.h>
 
 #include <audience.h>
@@ -66,7 +68,10 @@ int main(int argc, char **argv)
     options.add_options()("resizable", "Resizable window; use =false for non-resizable window", cxxopts::value<bool>());
     options.add_options()("top", "Window should stay on top always", cxxopts::value<bool>());
     options.add_options()("dev", "Developer mode; if supported by web view", cxxopts::value<bool>());
+    options.add_options()("compression", "Compress messages between shell and web app (permessage-deflate); if supported by web view", cxxopts::value<bool>());
+    options.add_options()("webview-pool", "Number of warm web views kept ready for new windows; if supported by nucleus", cxxopts::value<uint32_t>());
     options.add_options()("c,channel", "Command and event channel; a named pipe", cxxopts::value<std::string>());
+    options.add_options()("channel-json-payload", "Embed window messages which are valid JSON as nested payload into channel events", cxxopts::value<bool>());
     options.add_options()("h,help", "Print help", cxxopts::value<bool>());
 
     // parse arguments
@@ -133,7 +138,7 @@ int main(int argc, char **argv)
     bool do_create_channel = args["channel"].count() > 0;
     if (do_create_channel)
     {
-      channel_create(args["channel"].as<std::string>());
+      channel_create(args["channel"].as<std::string>(), args["channel-json-payload"].count() > 0 && args["channel-json-payload"].as<bool>());
     }
 
     // init audience
@@ -204,6 +209,16 @@ int main(int argc, char **argv)
       }
     }
 
+    if (args["compression"].count() > 0)
+    {
+      ad.transport.compression.enabled = args["compression"].as<bool>();
+    }
+
+    if (args["webview-pool"].count() > 0)
+    {
+      ad.webviews.pool_size = static_cast<uint8_t>(std::min<uint32_t>(args["webview-pool"].as<uint32_t>(), UINT8_MAX));
+    }
+
     AudienceAppEventHandler aeh{};
     if (do_create_channel)
     {
@@ -322,9 +337,17 @@ int main(int argc, char **argv)
     AudienceWindowEventHandler weh{};
     if (do_create_channel)
     {
-      weh.on_message.handler = [](AudienceWindowHandle handle, void *context, const wchar_t *message) {
+      weh.on_message_utf8.handler = [](AudienceWindowHandle handle, void *context, const char *message, size_t length) {
         SPDLOG_DEBUG("event window::message");
-        channel_emit_window_message(handle, message);
+        channel_emit_window_message(handle, message, length);
+      };
+      weh.on_binary.handler = [](AudienceWindowHandle handle, void *context, const void *data, size_t length) {
+        SPDLOG_DEBUG("event window::binary");
+        channel_emit_window_binary(handle, data, length);
+      };
+      weh.on_resync.handler = [](AudienceWindowHandle handle, void *context) {
+        SPDLOG_DEBUG("event window::resync");
+        channel_emit_window_resync(handle);
       };
       weh.on_close_intent.handler = [](AudienceWindowHandle handle, void *context) {
         SPDLOG_DEBUG("event window::close_intent");
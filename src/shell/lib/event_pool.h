@@ -0,0 +1,208 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <set>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+#include <audience_details.h>
+#include "../../common/fmt_exception.h"
+
+// Runs event handlers on a pool of worker threads, handlers of the same window run one after another in order
+class ShellEventPool
+{
+  struct State
+  {
+    std::mutex mutex;
+    std::condition_variable ready_condition;
+    std::condition_variable space_condition;
+    std::map<AudienceWindowHandle, std::deque<std::function<void()>>> queues;
+    std::set<AudienceWindowHandle> scheduled;
+    std::deque<AudienceWindowHandle> ready;
+    std::set<AudienceWindowHandle> closed;
+    std::size_t queue_limit = 0;
+    bool stopped = false;
+  };
+
+  // workers are detached and share the state, so they may outlive the pool at process exit
+  std::shared_ptr<State> state_;
+
+  static void work(std::shared_ptr<State> state)
+  {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (true)
+    {
+      state->ready_condition.wait(lock, [&] { return state->stopped || !state->ready.empty(); });
+      if (state->stopped)
+      {
+        return;
+      }
+
+      // take the next task of a window, no other worker touches this window meanwhile
+      auto handle = state->ready.front();
+      state->ready.pop_front();
+      auto &queue = state->queues[handle];
+      auto task = std::move(queue.front());
+      queue.pop_front();
+      state->space_condition.notify_all();
+
+      lock.unlock();
+      try
+      {
+        task();
+      }
+      catch (const std::exception &e)
+      {
+        SPDLOG_ERROR("{}", e);
+      }
+      catch (...)
+      {
+        SPDLOG_ERROR("unknown exception");
+      }
+      lock.lock();
+
+      // reschedule window, if more tasks arrived
+      auto iq = state->queues.find(handle);
+      if (iq == state->queues.end() || iq->second.empty())
+      {
+        if (iq != state->queues.end())
+        {
+          state->queues.erase(iq);
+        }
+        state->scheduled.erase(handle);
+      }
+      else
+      {
+        state->ready.push_back(handle);
+        state->ready_condition.notify_one();
+      }
+    }
+  }
+
+public:
+  bool running() const
+  {
+    return std::atomic_load(&state_) != nullptr;
+  }
+
+  void start(std::size_t threads, std::size_t queue_limit)
+  {
+    if (running())
+    {
+      return;
+    }
+
+    auto state = std::make_shared<State>();
+    state->queue_limit = std::max<std::size_t>(queue_limit, 1);
+    auto thread_count = std::max<std::size_t>(threads, 1);
+    for (std::size_t i = 0; i < thread_count; ++i)
+    {
+      std::thread(work, state).detach();
+    }
+    std::atomic_store(&state_, state);
+    SPDLOG_INFO("event pool started with {} threads", thread_count);
+  }
+
+  // returns false if the pool is not running, the window is closed or its queue is full and waiting is not allowed
+  bool post(AudienceWindowHandle handle, std::function<void()> task, bool wait)
+  {
+    auto state = std::atomic_load(&state_);
+    if (!state)
+    {
+      return false;
+    }
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    auto cancelled = [&] { return state->stopped || state->closed.count(handle) > 0; };
+    auto has_space = [&] { return cancelled() || state->queues[handle].size() < state->queue_limit; };
+    if (!has_space())
+    {
+      if (!wait)
+      {
+        return false;
+      }
+      state->space_condition.wait(lock, has_space);
+    }
+    if (cancelled())
+    {
+      return false;
+    }
+
+    state->queues[handle].push_back(std::move(task));
+    if (state->scheduled.insert(handle).second)
+    {
+      state->ready.push_back(handle);
+      state->ready_condition.notify_one();
+    }
+    return true;
+  }
+
+  // accepts tasks of a window (again), windows are open unless closed explicitly
+  void open(AudienceWindowHandle handle)
+  {
+    auto state = std::atomic_load(&state_);
+    if (state)
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->closed.erase(handle);
+    }
+  }
+
+  // drops pending tasks of a window and wakes up posters waiting for space, later posts fail,
+  // a task already running completes on its own
+  void close(AudienceWindowHandle handle)
+  {
+    auto state = std::atomic_load(&state_);
+    if (!state)
+    {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->closed.insert(handle);
+      auto iq = state->queues.find(handle);
+      if (iq != state->queues.end())
+      {
+        SPDLOG_DEBUG("dropping {} pending events of closed window {}", iq->second.size(), handle);
+        iq->second.clear();
+      }
+
+      // a window waiting for a worker is unscheduled right away, a running one by its worker
+      auto ir = std::find(state->ready.begin(), state->ready.end(), handle);
+      if (ir != state->ready.end())
+      {
+        state->ready.erase(ir);
+        state->queues.erase(handle);
+        state->scheduled.erase(handle);
+      }
+    }
+    state->space_condition.notify_all();
+  }
+
+  void stop()
+  {
+    auto state = std::atomic_exchange(&state_, std::shared_ptr<State>());
+    if (!state)
+    {
+      return;
+    }
+
+    // pending tasks are dropped, running ones complete on their own
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->stopped = true;
+      state->queues.clear();
+      state->ready.clear();
+    }
+    state->ready_condition.notify_all();
+    state->space_condition.notify_all();
+  }
+};
@@ -14,11 +14,15 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <set>
 #include <thread>
 #include <mutex>
+#include <shared_mutex>
 #include <algorithm>
 #include <iterator>
-#include <boost/bimap.hpp>
+#include <chrono>
+#include <functional>
+#include <optional>
 
 #include "../../common/safefn.h"
 #include "../../common/utf.h"
@@ -26,32 +30,32 @@
 #include "../../common/logger.h"
 #include "../../common/sys_error.h"
 #include "../../common/fmt_exception.h"
+#include "../../common/slot_map.h"
+#include "../../common/easing.h"
 #include "webserver/process.h"
 #include "lib.h"
 #include "nucleus.h"
 #include "util.h"
+#include "event_pool.h"
+#include "probe_cache.h"
+#ifdef AUDIENCE_STATIC_NUCLEUS
+#include "static_nucleus.h"
+#endif
 
-static std::mutex shell_thread_binding_mutex;
-static std::thread::id shell_thread_binding_id;
-
-#define SHELL_CHECK_THREAD_BINDING(on_fail)                                                                        \
-  {                                                                                                                \
-    bool thread_check_failed = false;                                                                              \
-    {                                                                                                              \
-      std::lock_guard<std::mutex> lock(shell_thread_binding_mutex);                                                \
-      if (shell_thread_binding_id == std::thread::id())                                                            \
-      {                                                                                                            \
-        throw std::runtime_error("audience needs to be locked to a specific thread (call audience_init() first)"); \
-      }                                                                                                            \
-      if (shell_thread_binding_id != std::this_thread::get_id())                                                   \
-      {                                                                                                            \
-        thread_check_failed = true;                                                                                \
-      }                                                                                                            \
-    }                                                                                                              \
-    if (thread_check_failed)                                                                                       \
-    {                                                                                                              \
-      on_fail;                                                                                                     \
-    }                                                                                                              \
+// bound once by audience_init, checked lock-free on every api call
+static std::atomic<std::thread::id> shell_thread_binding_id{};
+
+#define SHELL_CHECK_THREAD_BINDING(on_fail)                                                                      \
+  {                                                                                                              \
+    auto bound_thread_id = shell_thread_binding_id.load(std::memory_order_acquire);                              \
+    if (bound_thread_id == std::thread::id())                                                                    \
+    {                                                                                                            \
+      throw std::runtime_error("audience needs to be locked to a specific thread (call audience_init() first)"); \
+    }                                                                                                            \
+    if (bound_thread_id != std::this_thread::get_id())                                                           \
+    {                                                                                                            \
+      on_fail;                                                                                                   \
+    }                                                                                                            \
   }
 
 #define SHELL_CHECK_THREAD_BINDING_THROW SHELL_CHECK_THREAD_BINDING(throw std::runtime_error("audience cannot be called from multiple threads (stick to your applications main thread)"))
@@ -103,45 +107,229 @@ static nucleus_main_t nucleus_main = nullptr;
 
 static std::atomic<nucleus_dispatch_sync_t> nucleus_dispatch_sync = nullptr;
 static std::atomic<nucleus_dispatch_async_t> nucleus_dispatch_async = nullptr;
+static nucleus_dispatch_after_t nucleus_dispatch_after = nullptr;
+
+// optional, only nuclei which can be driven by a foreign event loop export them
+static nucleus_event_fd_t nucleus_event_fd = nullptr;
+static nucleus_poll_t nucleus_poll = nullptr;
+static nucleus_window_animate_t nucleus_window_animate = nullptr; // emulated by stepping positions if missing
 
 static AudienceNucleusProtocolNegotiation shell_protocol_negotiation{};
-static boost::bimap<AudienceWindowHandle, WebserverContext> shell_webserver_registry{};
 
-static AudienceAppEventHandler audience_app_event_handler{};
-static std::map<AudienceWindowHandle, AudienceWindowEventHandler> audience_window_event_handler{};
+// state of an isolated app session, all contexts share the nucleus and its main loop
+struct AudienceContextData
+{
+  AudienceAppEventHandler event_handler{};
+  WebserverOptions webserver_options{};
+  ShellEventPool event_pool{};
+  std::size_t event_pool_size = 2;
+  std::size_t event_pool_queue_limit = 256;
+  bool destroyed = false; // windows of a destroyed context stay alive until closed, but emit no events anymore
+};
+typedef std::shared_ptr<AudienceContextData> ShellContext;
+static std::map<AudienceContext, ShellContext> shell_contexts{}; // modified on main thread only
+static ShellContext shell_context_default{};
+static std::atomic<AudienceContext> shell_context_default_id{}; // mirror of shell_context_default for other threads
+
+struct ShellWindow
+{
+  ShellContext owner;
+  WebserverContext webserver; // empty if nucleus handles messaging
+  AudienceWindowEventHandler event_handler;
+};
+struct ShellWindowWebserverKey
+{
+  WebserverContext operator()(const ShellWindow &window) const { return window.webserver; }
+};
+static slot_map<ShellWindow, 8, ShellWindowWebserverKey> shell_windows{}; // keyed by handles of nucleus, indexed by webserver, modified on main thread only
+static std::shared_mutex shell_webserver_registry_mutex;                  // guards modifications against lookups from other threads
+static std::set<AudienceWindowHandle> shell_state_dirty{};
+static bool shell_state_flush_scheduled = false;
+
+struct ShellPoolWindow
+{
+  AudienceWindowHandle handle;
+  AudienceWindowEventHandler event_handler;
+  ShellContext owner;
+};
+static std::mutex shell_event_pool_windows_mutex;
+static std::map<WebserverContext, ShellPoolWindow> shell_event_pool_windows{};
+
+struct ShellTimer
+{
+  std::chrono::steady_clock::duration interval;
+  std::chrono::steady_clock::time_point deadline;
+  void (*handler)(AudienceTimerHandle handle, void *context);
+  void *context;
+  AudienceContext owner;
+};
+static std::map<AudienceTimerHandle, ShellTimer> shell_timers{};
+static AudienceTimerHandle shell_timer_next_handle = 1;
+static uintptr_t shell_timer_generation = 0;
+static bool shell_timer_armed = false;
+static std::chrono::steady_clock::time_point shell_timer_wakeup{};
+
+struct ShellAnimation
+{
+  AudienceWindowAnimationHandler on_end;
+  void *context;
+  uintptr_t id;
+  // only used if the nucleus cannot animate by itself
+  std::chrono::steady_clock::time_point start;
+  std::chrono::steady_clock::duration duration;
+  AudienceRect from;
+  AudienceRect to;
+  AudienceEasing easing;
+};
+static std::map<AudienceWindowHandle, ShellAnimation> shell_animations{}; // one per window at most, modified on main thread only
+static uintptr_t shell_animation_next_id = 1;
 
 static std::atomic<bool> audience_is_initialized = false;
 static std::atomic<bool> audience_is_shutdown = false;
 
 static inline void shell_unsafe_on_window_message(AudienceWindowHandle handle, const wchar_t *message);
+static inline void shell_unsafe_on_window_message_utf8(AudienceWindowHandle handle, const char *message, size_t length);
+static inline void shell_unsafe_on_window_binary(AudienceWindowHandle handle, const void *data, size_t length);
+static inline void shell_unsafe_on_window_resync(AudienceWindowHandle handle);
 static inline void shell_unsafe_on_window_close_intent(AudienceWindowHandle handle);
 static inline void shell_unsafe_on_window_close(AudienceWindowHandle handle, bool is_last_window);
+static inline void shell_unsafe_on_window_geometry_change(AudienceWindowHandle handle, AudienceRect frame, AudienceSize workspace);
+static inline void shell_unsafe_on_window_focus_change(AudienceWindowHandle handle, bool has_focus);
+static inline void shell_unsafe_on_window_animation_complete(AudienceWindowHandle handle);
+static inline bool shell_deliver_from_webserver(WebserverContext context, bool binary, std::string_view data);
 static inline void shell_unsafe_on_app_quit();
 
-static inline bool shell_unsafe_init(const AudienceAppDetails *details, const AudienceAppEventHandler *event_handler)
+// binds the nucleus functions resolved by lookup and tries to initialize the nucleus,
+// all function pointers are reset if the nucleus is incomplete or fails to initialize
+static inline bool shell_bind_nucleus(const std::function<void *(const char *)> &lookup, const std::wstring &dylib, const AudienceNucleusAppDetails &nucleus_details)
+{
+  auto started = std::chrono::steady_clock::now();
+
+  nucleus_init = (nucleus_init_t)lookup("nucleus_init");
+  nucleus_screen_list = (nucleus_screen_list_t)lookup("nucleus_screen_list");
+  nucleus_window_list = (nucleus_window_list_t)lookup("nucleus_window_list");
+  nucleus_window_create = (nucleus_window_create_t)lookup("nucleus_window_create");
+  nucleus_window_update_position = (nucleus_window_update_position_t)lookup("nucleus_window_update_position");
+  nucleus_window_post_message = (nucleus_window_post_message_t)lookup("nucleus_window_post_message");
+  nucleus_window_destroy = (nucleus_window_destroy_t)lookup("nucleus_window_destroy");
+  nucleus_quit = (nucleus_quit_t)lookup("nucleus_quit");
+  nucleus_main = (nucleus_main_t)lookup("nucleus_main");
+  nucleus_dispatch_sync = (nucleus_dispatch_sync_t)lookup("nucleus_dispatch_sync");
+  nucleus_dispatch_async = (nucleus_dispatch_async_t)lookup("nucleus_dispatch_async");
+  nucleus_dispatch_after = (nucleus_dispatch_after_t)lookup("nucleus_dispatch_after");
+  nucleus_event_fd = (nucleus_event_fd_t)lookup("nucleus_event_fd");
+  nucleus_poll = (nucleus_poll_t)lookup("nucleus_poll");
+  nucleus_window_animate = (nucleus_window_animate_t)lookup("nucleus_window_animate");
+
+  bool all_funcs_available = nucleus_init != nullptr && nucleus_screen_list != nullptr && nucleus_window_list != nullptr && nucleus_window_create != nullptr && nucleus_window_update_position != nullptr && nucleus_window_post_message != nullptr && nucleus_window_destroy != nullptr && nucleus_quit != nullptr && nucleus_main != nullptr && nucleus_dispatch_sync.load() != nullptr && nucleus_dispatch_async.load() != nullptr && nucleus_dispatch_after != nullptr;
+
+  if (!all_funcs_available)
+  {
+    SPDLOG_INFO("could not find function pointer in library {}", utf16_to_utf8(dylib));
+  }
+
+  // try to initializes and negotiate protocol
+  shell_protocol_negotiation = {};
+  shell_protocol_negotiation.shell_event_handler.window_level.on_message = SAFE_FN(shell_unsafe_on_window_message);
+  shell_protocol_negotiation.shell_event_handler.window_level.on_close_intent = SAFE_FN(shell_unsafe_on_window_close_intent);
+  shell_protocol_negotiation.shell_event_handler.window_level.on_close = SAFE_FN(shell_unsafe_on_window_close);
+  shell_protocol_negotiation.shell_event_handler.window_level.on_geometry_change = SAFE_FN(shell_unsafe_on_window_geometry_change);
+  shell_protocol_negotiation.shell_event_handler.window_level.on_focus_change = SAFE_FN(shell_unsafe_on_window_focus_change);
+  shell_protocol_negotiation.shell_event_handler.window_level.on_animation_complete = SAFE_FN(shell_unsafe_on_window_animation_complete);
+  shell_protocol_negotiation.shell_event_handler.app_level.on_quit = SAFE_FN(shell_unsafe_on_app_quit);
+
+  if (all_funcs_available && nucleus_init(&shell_protocol_negotiation, &nucleus_details))
+  {
+    // set init state
+    audience_is_initialized = true;
+    SPDLOG_INFO("library {} loaded successfully in {} ms", utf16_to_utf8(dylib), std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count());
+    return true;
+  }
+  else
+  {
+    SPDLOG_INFO("could not initialize library {}", utf16_to_utf8(dylib));
+  }
+
+  // reset function pointer and negotiation in case we failed
+  nucleus_init = nullptr;
+  nucleus_screen_list = nullptr;
+  nucleus_window_list = nullptr;
+  nucleus_window_create = nullptr;
+  nucleus_window_update_position = nullptr;
+  nucleus_window_post_message = nullptr;
+  nucleus_window_destroy = nullptr;
+  nucleus_quit = nullptr;
+  nucleus_main = nullptr;
+  nucleus_dispatch_sync = nullptr;
+  nucleus_dispatch_async = nullptr;
+  nucleus_dispatch_after = nullptr;
+  nucleus_event_fd = nullptr;
+  nucleus_poll = nullptr;
+  nucleus_window_animate = nullptr;
+  shell_protocol_negotiation = {};
+  return false;
+}
+
+static inline void shell_bind_thread()
 {
   // setup logger
   setup_logger("audience.shell.lib");
 
   // perform thread binding if not bound already
+  auto unbound = std::thread::id();
+  shell_thread_binding_id.compare_exchange_strong(unbound, std::this_thread::get_id(), std::memory_order_acq_rel);
+}
+
+static inline void shell_context_configure(AudienceContextData &context, const AudienceAppDetails *details)
+{
+  // prepare webserver options
+  auto &webserver_options = context.webserver_options;
+  webserver_options = {};
+  webserver_options.compression.enabled = details->transport.compression.enabled;
+  if (details->transport.compression.window_bits != 0)
   {
-    std::lock_guard<std::mutex> lock(shell_thread_binding_mutex);
-    if (shell_thread_binding_id == std::thread::id())
-    {
-      shell_thread_binding_id = std::this_thread::get_id();
-    }
+    webserver_options.compression.window_bits = details->transport.compression.window_bits;
   }
-
-  // validate thread binding
-  SHELL_CHECK_THREAD_BINDING_THROW;
-
-  // prevent double initialization
-  if (audience_is_initialized.load())
+  if (details->transport.compression.mem_level != 0)
   {
-    SPDLOG_DEBUG("prevent double initialization");
-    return true;
+    webserver_options.compression.mem_level = details->transport.compression.mem_level;
+  }
+  if (details->transport.fragment_size != 0)
+  {
+    webserver_options.fragment_size = details->transport.fragment_size;
+  }
+  if (details->transport.replay_capacity != 0)
+  {
+    webserver_options.replay.capacity = details->transport.replay_capacity;
+  }
+  if (details->transport.limits.http_idle_timeout != 0)
+  {
+    webserver_options.limits.http_idle_timeout = std::chrono::seconds(details->transport.limits.http_idle_timeout);
+  }
+  if (details->transport.limits.websocket_idle_timeout != 0)
+  {
+    webserver_options.limits.websocket_idle_timeout = std::chrono::seconds(details->transport.limits.websocket_idle_timeout);
+  }
+  if (details->transport.limits.body_limit != 0)
+  {
+    webserver_options.limits.body_limit = details->transport.limits.body_limit;
+  }
+  if (details->transport.limits.message_limit != 0)
+  {
+    webserver_options.limits.message_limit = details->transport.limits.message_limit;
+  }
+  if (details->transport.limits.max_connections != 0)
+  {
+    webserver_options.limits.max_connections = details->transport.limits.max_connections;
   }
 
+  // prepare event pool options
+  context.event_pool_size = details->workers.pool_size != 0 ? details->workers.pool_size : 2;
+  context.event_pool_queue_limit = details->workers.queue_limit != 0 ? details->workers.queue_limit : 256;
+}
+
+static inline bool shell_unsafe_load_nucleus(const AudienceAppDetails *details)
+{
   // nucleus library load order
   std::vector<std::wstring> dylibs{};
   for (size_t i = 0; i < AUDIENCE_APP_DETAILS_LOAD_ORDER_ENTRIES; ++i)
@@ -186,6 +374,7 @@ static inline bool shell_unsafe_init(const AudienceAppDetails *details, const Au
 
   // prepare internal details
   AudienceNucleusAppDetails nucleus_details{};
+  nucleus_details.webview_pool_size = details->webviews.pool_size;
 
   std::vector<std::wstring> icon_set_absolute; // ... keeps memory alive
   for (size_t i = 0; i < AUDIENCE_APP_DETAILS_ICON_SET_ENTRIES; ++i)
@@ -205,20 +394,75 @@ static inline bool shell_unsafe_init(const AudienceAppDetails *details, const Au
     }
   }
 
-  // iterate libraries and stop at first successful load
-  for (auto dylib : dylibs)
+  // resolve library paths and keep their priority order, except for libraries which failed
+  // recently: those are only retried as a last resort
+  auto exe_dir = dir_of_exe();
+  ShellProbeCache probe_cache{};
+  probe_cache.load(exe_dir);
+
+  std::vector<std::pair<std::wstring, std::wstring>> candidates{}, known_failures{};
+#ifdef AUDIENCE_STATIC_NUCLEUS
+  bool linked_nucleus_requested = false;
+#endif
+  for (auto &dylib : dylibs)
   {
-    // load library
+#ifdef AUDIENCE_STATIC_NUCLEUS
+    if (dylib == utf8_to_utf16(static_nucleus_library))
+    {
+      linked_nucleus_requested = true;
+      continue;
+    }
+#endif
+
     std::wstring dylib_abs;
     try
     {
-      dylib_abs = normalize_path(dir_of_exe() + L"/" + dylib);
+      dylib_abs = normalize_path(exe_dir + L"/" + dylib);
     }
     catch (const std::invalid_argument &e)
     {
       SPDLOG_ERROR("{}", e);
       continue;
     }
+
+    if (probe_cache.failed(dylib_abs))
+    {
+      SPDLOG_DEBUG("library {} failed before, deferring it", utf16_to_utf8(dylib));
+      known_failures.push_back({dylib, dylib_abs});
+    }
+    else
+    {
+      candidates.push_back({dylib, dylib_abs});
+    }
+  }
+  candidates.insert(candidates.end(), known_failures.begin(), known_failures.end());
+
+#ifdef AUDIENCE_STATIC_NUCLEUS
+  // linked nucleus goes first, it was chosen at build time (empty path marks it)
+  if (linked_nucleus_requested)
+  {
+    candidates.insert(candidates.begin(), {utf8_to_utf16(static_nucleus_library), std::wstring()});
+  }
+#endif
+
+  // iterate libraries and stop at first successful load
+  for (auto &[dylib, dylib_abs] : candidates)
+  {
+#ifdef AUDIENCE_STATIC_NUCLEUS
+    // linked nucleus is bound through its table, no library to load
+    if (dylib_abs.empty())
+    {
+      SPDLOG_INFO("trying linked nucleus {}", utf16_to_utf8(dylib));
+      if (shell_bind_nucleus(static_nucleus_lookup, dylib, nucleus_details))
+      {
+        return true;
+      }
+      SPDLOG_WARN("could not initialize linked nucleus, falling back to loading libraries");
+      continue;
+    }
+#endif
+
+    // load library
     SPDLOG_INFO("trying to load library from path {}", utf16_to_utf8(dylib_abs));
 #ifdef WIN32
     auto dlh = LoadLibraryW(dylib_abs.c_str());
@@ -229,67 +473,27 @@ static inline bool shell_unsafe_init(const AudienceAppDetails *details, const Au
     // try to lookup symbols if loaded successfully
     if (dlh != nullptr)
     {
+      auto lookup = [dlh](const char *name) {
 #ifdef WIN32
-#define LookupFunction GetProcAddress
+        return reinterpret_cast<void *>(GetProcAddress(dlh, name));
 #else
-#define LookupFunction dlsym
+        return dlsym(dlh, name);
 #endif
+      };
 
-      nucleus_init = (nucleus_init_t)LookupFunction(dlh, "nucleus_init");
-      nucleus_screen_list = (nucleus_screen_list_t)LookupFunction(dlh, "nucleus_screen_list");
-      nucleus_window_list = (nucleus_window_list_t)LookupFunction(dlh, "nucleus_window_list");
-      nucleus_window_create = (nucleus_window_create_t)LookupFunction(dlh, "nucleus_window_create");
-      nucleus_window_update_position = (nucleus_window_update_position_t)LookupFunction(dlh, "nucleus_window_update_position");
-      nucleus_window_post_message = (nucleus_window_post_message_t)LookupFunction(dlh, "nucleus_window_post_message");
-      nucleus_window_destroy = (nucleus_window_destroy_t)LookupFunction(dlh, "nucleus_window_destroy");
-      nucleus_quit = (nucleus_quit_t)LookupFunction(dlh, "nucleus_quit");
-      nucleus_main = (nucleus_main_t)LookupFunction(dlh, "nucleus_main");
-      nucleus_dispatch_sync = (nucleus_dispatch_sync_t)LookupFunction(dlh, "nucleus_dispatch_sync");
-      nucleus_dispatch_async = (nucleus_dispatch_async_t)LookupFunction(dlh, "nucleus_dispatch_async");
-
-      bool all_funcs_available = nucleus_init != nullptr && nucleus_screen_list != nullptr && nucleus_window_list != nullptr && nucleus_window_create != nullptr && nucleus_window_update_position != nullptr && nucleus_window_post_message != nullptr && nucleus_window_destroy != nullptr && nucleus_quit != nullptr && nucleus_main != nullptr && nucleus_dispatch_sync.load() != nullptr && nucleus_dispatch_async.load() != nullptr;
-
-      if (!all_funcs_available)
-      {
-        SPDLOG_INFO("could not find function pointer in library {}", utf16_to_utf8(dylib));
-      }
-
-      // try to initializes and negotiate protocol
-      shell_protocol_negotiation = {};
-      shell_protocol_negotiation.shell_event_handler.window_level.on_message = SAFE_FN(shell_unsafe_on_window_message);
-      shell_protocol_negotiation.shell_event_handler.window_level.on_close_intent = SAFE_FN(shell_unsafe_on_window_close_intent);
-      shell_protocol_negotiation.shell_event_handler.window_level.on_close = SAFE_FN(shell_unsafe_on_window_close);
-      shell_protocol_negotiation.shell_event_handler.app_level.on_quit = SAFE_FN(shell_unsafe_on_app_quit);
-
-      if (all_funcs_available && nucleus_init(&shell_protocol_negotiation, &nucleus_details))
+      if (shell_bind_nucleus(lookup, dylib, nucleus_details))
       {
-        // copy event handler info and set init state
-        audience_app_event_handler = *event_handler;
-        audience_is_initialized = true;
-        SPDLOG_INFO("library {} loaded successfully", utf16_to_utf8(dylib));
+        probe_cache.forget(dylib_abs);
+        probe_cache.save();
         return true;
       }
-      else
-      {
-        SPDLOG_INFO("could not initialize library {}", utf16_to_utf8(dylib));
-      }
-
-      // reset function pointer and negotiation in case we failed
-      nucleus_init = nullptr;
-      nucleus_window_create = nullptr;
-      nucleus_window_post_message = nullptr;
-      nucleus_window_destroy = nullptr;
-      nucleus_quit = nullptr;
-      nucleus_main = nullptr;
-      nucleus_dispatch_sync = nullptr;
-      nucleus_dispatch_async = nullptr;
-      shell_protocol_negotiation = {};
 
 #ifdef WIN32
       FreeLibrary(dlh);
 #else
       dlclose(dlh);
 #endif
+      probe_cache.record_failure(dylib_abs);
     }
     else
     {
@@ -299,20 +503,171 @@ static inline bool shell_unsafe_init(const AudienceAppDetails *details, const Au
 #else
       SPDLOG_WARN("{}", dlerror());
 #endif
+      probe_cache.record_failure(dylib_abs);
     }
   }
 
+  probe_cache.save();
   SPDLOG_ERROR("initialization failed");
   return false;
 }
 
+static inline AudienceContext shell_unsafe_context_create(const AudienceAppDetails *details, const AudienceAppEventHandler *event_handler)
+{
+  shell_bind_thread();
+
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC(audience_context_create, AudienceContext, details, event_handler));
+
+  // ensure we are not shutting down
+  if (audience_is_shutdown.load())
+  {
+    SPDLOG_DEBUG("cannot call api in shutdown state");
+    return nullptr;
+  }
+
+  if (details == nullptr || event_handler == nullptr)
+  {
+    throw std::invalid_argument("app details and event handler must not be null");
+  }
+
+  // the first context loads the nucleus, its load order and icon set apply to all contexts
+  if (!audience_is_initialized.load() && !shell_unsafe_load_nucleus(details))
+  {
+    return nullptr;
+  }
+
+  auto context = std::make_shared<AudienceContextData>();
+  context->event_handler = *event_handler;
+  shell_context_configure(*context, details);
+  shell_contexts[context.get()] = context;
+  SPDLOG_INFO("context created, {} contexts in total", shell_contexts.size());
+
+  return context.get();
+}
+
+AudienceContext audience_context_create(const AudienceAppDetails *details, const AudienceAppEventHandler *event_handler)
+{
+  return SAFE_FN(shell_unsafe_context_create, SAFE_FN_DEFAULT(AudienceContext))(details, event_handler);
+}
+
+static inline bool shell_unsafe_init(const AudienceAppDetails *details, const AudienceAppEventHandler *event_handler)
+{
+  shell_bind_thread();
+
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING_THROW;
+
+  // prevent double initialization
+  if (shell_context_default)
+  {
+    SPDLOG_DEBUG("prevent double initialization");
+    return true;
+  }
+
+  // create default context, which is used by all functions without context parameter
+  auto context = shell_unsafe_context_create(details, event_handler);
+  if (context == nullptr)
+  {
+    return false;
+  }
+  shell_context_default = shell_contexts[context];
+  shell_context_default_id = context;
+  return true;
+}
+
 bool audience_init(const AudienceAppDetails *details, const AudienceAppEventHandler *event_handler)
 {
   return SAFE_FN(shell_unsafe_init, SAFE_FN_DEFAULT(bool))(details, event_handler);
 }
 
+// resolves a context handle on the main thread, nullptr selects the default context
+static inline ShellContext shell_context_resolve(AudienceContext context)
+{
+  if (context == nullptr)
+  {
+    if (!shell_context_default)
+    {
+      throw std::runtime_error("no default context available (call audience_init() first)");
+    }
+    return shell_context_default;
+  }
+  auto ic = shell_contexts.find(context);
+  if (ic == shell_contexts.end())
+  {
+    throw std::invalid_argument("unknown or destroyed context");
+  }
+  return ic->second;
+}
+
+static inline AudienceContext shell_unsafe_context_default()
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC(audience_context_default, AudienceContext));
+
+  return shell_context_default.get();
+}
+
+AudienceContext audience_context_default()
+{
+  return SAFE_FN(shell_unsafe_context_default, SAFE_FN_DEFAULT(AudienceContext))();
+}
+
+static inline void shell_unsafe_context_destroy(AudienceContext context)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC_VOID(audience_context_destroy, context));
+
+  // unregister context
+  auto owner = shell_context_resolve(context);
+  shell_contexts.erase(owner.get());
+  if (shell_context_default == owner)
+  {
+    shell_context_default.reset();
+    shell_context_default_id = nullptr;
+  }
+  owner->destroyed = true;
+
+  // stop its timers and workers, pending wakeups find nothing to do
+  for (auto it = shell_timers.begin(); it != shell_timers.end();)
+  {
+    it = it->second.owner == owner.get() ? shell_timers.erase(it) : std::next(it);
+  }
+  owner->event_pool.stop();
+
+  // destroy its windows, the records keep the context alive until the windows are closed
+  std::vector<AudienceWindowHandle> handles;
+  shell_windows.for_each([&](AudienceWindowHandle handle, ShellWindow &window) {
+    if (window.owner == owner)
+    {
+      handles.push_back(handle);
+    }
+  });
+  for (auto handle : handles)
+  {
+    nucleus_window_destroy(handle);
+  }
+  SPDLOG_INFO("context destroyed, {} contexts left", shell_contexts.size());
+}
+
+void audience_context_destroy(AudienceContext context)
+{
+  return SAFE_FN(shell_unsafe_context_destroy)(context);
+}
+
+static inline bool shell_geometry_published()
+{
+  return audience_is_initialized.load() && !audience_is_shutdown.load() && shell_protocol_negotiation.nucleus_publishes_geometry;
+}
+
 static inline AudienceScreenList shell_unsafe_screen_list()
 {
+  // snapshot of nucleus can be read from any thread, no round trip to the main thread needed
+  if (shell_geometry_published())
+  {
+    return nucleus_screen_list();
+  }
+
   // validate thread binding
   SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC(audience_screen_list, AudienceScreenList));
 
@@ -332,10 +687,40 @@ AudienceScreenList audience_screen_list()
   return SAFE_FN(shell_unsafe_screen_list, SAFE_FN_DEFAULT(AudienceScreenList))();
 }
 
-static inline AudienceWindowList shell_unsafe_window_list()
+static inline AudienceWindowList shell_filter_window_list(const AudienceWindowList &all, AudienceContext owner)
+{
+  AudienceWindowList result{};
+  result.focused = -1;
+  for (uint8_t i = 0; i < all.count; ++i)
+  {
+    auto window = shell_windows.find(all.windows[i].handle);
+    if (window == nullptr || window->owner.get() != owner)
+    {
+      continue;
+    }
+    if (all.focused == i)
+    {
+      result.focused = result.count;
+    }
+    result.windows[result.count] = all.windows[i];
+    result.count += 1;
+  }
+  return result;
+}
+
+static inline AudienceWindowList shell_unsafe_context_window_list(AudienceContext app_context)
 {
+  // snapshot of nucleus can be read from any thread, window records are guarded by the registry lock
+  if (shell_geometry_published() && shell_thread_binding_id.load(std::memory_order_acquire) != std::this_thread::get_id())
+  {
+    auto owner = app_context != nullptr ? app_context : shell_context_default_id.load();
+    auto all = nucleus_window_list();
+    std::shared_lock<std::shared_mutex> lock(shell_webserver_registry_mutex);
+    return shell_filter_window_list(all, owner);
+  }
+
   // validate thread binding
-  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC(audience_window_list, AudienceWindowList));
+  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC(audience_context_window_list, AudienceWindowList, app_context));
 
   // ensure initialization
   if (!audience_is_initialized.load() || audience_is_shutdown.load())
@@ -344,19 +729,24 @@ static inline AudienceWindowList shell_unsafe_window_list()
     return AudienceWindowList{};
   }
 
-  // get window list
-  return nucleus_window_list();
+  // get window list and keep windows of context only
+  return shell_filter_window_list(nucleus_window_list(), shell_context_resolve(app_context).get());
+}
+
+AudienceWindowList audience_context_window_list(AudienceContext app_context)
+{
+  return SAFE_FN(shell_unsafe_context_window_list, SAFE_FN_DEFAULT(AudienceWindowList))(app_context);
 }
 
 AudienceWindowList audience_window_list()
 {
-  return SAFE_FN(shell_unsafe_window_list, SAFE_FN_DEFAULT(AudienceWindowList))();
+  return audience_context_window_list(nullptr);
 }
 
-static inline AudienceWindowHandle shell_unsafe_window_create(const AudienceWindowDetails *details, const AudienceWindowEventHandler *event_handler)
+static inline AudienceWindowHandle shell_unsafe_context_window_create(AudienceContext app_context, const AudienceWindowDetails *details, const AudienceWindowEventHandler *event_handler)
 {
   // validate thread binding
-  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC(audience_window_create, AudienceWindowHandle, details, event_handler));
+  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC(audience_context_window_create, AudienceWindowHandle, app_context, details, event_handler));
 
   // ensure initialization
   if (!audience_is_initialized.load() || audience_is_shutdown.load())
@@ -365,6 +755,9 @@ static inline AudienceWindowHandle shell_unsafe_window_create(const AudienceWind
     return {};
   }
 
+  // windows belong to a context
+  auto owner = shell_context_resolve(app_context);
+
   // translate web app location to absolute path
   AudienceWindowDetails new_details = *details;
   std::wstring webapp_dir_absolute; // ... variable from outer scope keeps memory alive
@@ -395,13 +788,50 @@ static inline AudienceWindowHandle shell_unsafe_window_create(const AudienceWind
     std::string address = "127.0.0.1";
     unsigned short ws_port = 0;
 
-    auto ws_ctx = webserver_start(address, ws_port, utf16_to_utf8(new_details.webapp_location), 3, [](WebserverContext context, std::wstring message) {
+    auto ws_ctx = webserver_start(address, ws_port, utf16_to_utf8(new_details.webapp_location), 3, owner->webserver_options, [](WebserverContext context, std::string_view message) {
+      if (shell_deliver_from_webserver(context, false, message))
+      {
+        return;
+      }
+      auto task_lambda = [&]() {
+        auto wh = shell_windows.find_handle(context);
+        if (wh != AudienceWindowHandle{})
+        {
+          shell_unsafe_on_window_message_utf8(wh, message.data(), message.size());
+        }
+      };
+      auto task = [](void *context) { (*static_cast<decltype(task_lambda) *>(context))(); };
+      auto ds = nucleus_dispatch_sync.load();
+      if (ds != nullptr)
+      {
+        ds(task, &task_lambda);
+      }
+    },
+    [](WebserverContext context, std::string_view data) {
+      if (shell_deliver_from_webserver(context, true, data))
+      {
+        return;
+      }
+      auto task_lambda = [&]() {
+        auto wh = shell_windows.find_handle(context);
+        if (wh != AudienceWindowHandle{})
+        {
+          shell_unsafe_on_window_binary(wh, data.data(), data.size());
+        }
+      };
+      auto task = [](void *context) { (*static_cast<decltype(task_lambda) *>(context))(); };
+      auto ds = nucleus_dispatch_sync.load();
+      if (ds != nullptr)
+      {
+        ds(task, &task_lambda);
+      }
+    },
+    [](WebserverContext context) {
       auto task_lambda = [&]() {
-        auto ic = shell_webserver_registry.right.find(context);
-        if (ic != shell_webserver_registry.right.end())
+        auto wh = shell_windows.find_handle(context);
+        if (wh != AudienceWindowHandle{})
         {
-          auto wh = ic->second;
-          shell_unsafe_on_window_message(wh, message.c_str());
+          shell_unsafe_on_window_resync(wh);
         }
       };
       auto task = [](void *context) { (*static_cast<decltype(task_lambda) *>(context))(); };
@@ -432,8 +862,9 @@ static inline AudienceWindowHandle shell_unsafe_window_create(const AudienceWind
     }
     else
     {
-      // attach webserver to registry
-      shell_webserver_registry.insert(boost::bimap<AudienceWindowHandle, WebserverContext>::value_type(window_handle, ws_ctx));
+      // attach webserver to window
+      std::unique_lock<std::shared_mutex> lock(shell_webserver_registry_mutex);
+      shell_windows.insert_at(window_handle, ShellWindow{owner, ws_ctx, *event_handler});
     }
   }
   else
@@ -442,76 +873,817 @@ static inline AudienceWindowHandle shell_unsafe_window_create(const AudienceWind
   }
 
   // copy event handler info
-  if (window_handle != AudienceWindowHandle{})
+  if (window_handle != AudienceWindowHandle{} && shell_windows.find(window_handle) == nullptr)
+  {
+    std::unique_lock<std::shared_mutex> lock(shell_webserver_registry_mutex);
+    shell_windows.insert_at(window_handle, ShellWindow{owner, WebserverContext{}, *event_handler});
+  }
+
+  // messages of this window bypass the main thread, if requested
+  if (window_handle != AudienceWindowHandle{} && event_handler->message_delivery == AUDIENCE_EVENT_DELIVERY_WORKER_POOL)
   {
-    audience_window_event_handler[window_handle] = *event_handler;
+    owner->event_pool.start(owner->event_pool_size, owner->event_pool_queue_limit);
+    owner->event_pool.open(window_handle);
+    auto window = shell_windows.find(window_handle);
+    if (window != nullptr && window->webserver)
+    {
+      std::lock_guard<std::mutex> lock(shell_event_pool_windows_mutex);
+      shell_event_pool_windows[window->webserver] = {window_handle, *event_handler, owner};
+    }
   }
 
   return window_handle;
 }
 
+AudienceWindowHandle audience_context_window_create(AudienceContext app_context, const AudienceWindowDetails *details, const AudienceWindowEventHandler *event_handler)
+{
+  return SAFE_FN(shell_unsafe_context_window_create, SAFE_FN_DEFAULT(AudienceWindowHandle))(app_context, details, event_handler);
+}
+
 AudienceWindowHandle audience_window_create(const AudienceWindowDetails *details, const AudienceWindowEventHandler *event_handler)
 {
-  return SAFE_FN(shell_unsafe_window_create, SAFE_FN_DEFAULT(AudienceWindowHandle))(details, event_handler);
+  return audience_context_window_create(nullptr, details, event_handler);
 }
 
-static inline void shell_unsafe_window_update_position(AudienceWindowHandle handle, AudienceRect position)
+static inline void shell_unsafe_dispatch_function(void *function)
 {
-  // validate thread binding
-  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC_VOID(audience_window_update_position, handle, position));
+  std::unique_ptr<std::function<void()>> owned_function(static_cast<std::function<void()> *>(function));
+  (*owned_function)();
+}
 
-  // ensure initialization
-  if (!audience_is_initialized.load() || audience_is_shutdown.load())
+static inline bool shell_dispatch_async_function(std::function<void()> function)
+{
+  // queue on main loop without waiting, calls from all threads are pipelined in order
+  auto da = nucleus_dispatch_async.load();
+  if (da == nullptr)
   {
-    SPDLOG_DEBUG("cannot call api in unitialized state");
-    return;
+    return false;
   }
+  da(SAFE_FN(shell_unsafe_dispatch_function), new std::function<void()>(std::move(function)));
+  return true;
+}
 
-  // update window position
-  return nucleus_window_update_position(handle, position);
+static inline void shell_unsafe_context_window_create_async(AudienceContext app_context, const AudienceWindowDetails *details, const AudienceWindowEventHandler *event_handler, AudienceWindowCompletionHandler on_complete, void *context)
+{
+  if (details == nullptr || event_handler == nullptr || details->webapp_location == nullptr)
+  {
+    throw std::invalid_argument("window details and event handler must not be null");
+  }
+
+  // copy details, the caller may release them as soon as we return
+  auto webapp_location = std::wstring(details->webapp_location);
+  auto loading_title = details->loading_title != nullptr ? std::optional<std::wstring>(details->loading_title) : std::nullopt;
+  auto details_copy = *details;
+  auto event_handler_copy = *event_handler;
+
+  auto dispatched = shell_dispatch_async_function([=]() mutable {
+    details_copy.webapp_location = webapp_location.c_str();
+    details_copy.loading_title = loading_title ? loading_title->c_str() : nullptr;
+    auto handle = audience_context_window_create(app_context, &details_copy, &event_handler_copy);
+    if (on_complete != nullptr)
+    {
+      on_complete(handle, context);
+    }
+  });
+
+  if (!dispatched)
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    if (on_complete != nullptr)
+    {
+      on_complete(AudienceWindowHandle{}, context);
+    }
+  }
 }
 
-void audience_window_update_position(AudienceWindowHandle handle, AudienceRect position)
+void audience_context_window_create_async(AudienceContext app_context, const AudienceWindowDetails *details, const AudienceWindowEventHandler *event_handler, AudienceWindowCompletionHandler on_complete, void *context)
 {
-  return SAFE_FN(shell_unsafe_window_update_position)(handle, position);
+  return SAFE_FN(shell_unsafe_context_window_create_async)(app_context, details, event_handler, on_complete, context);
 }
 
-static inline void shell_unsafe_window_post_message(AudienceWindowHandle handle, const wchar_t *message)
+void audience_window_create_async(const AudienceWindowDetails *details, const AudienceWindowEventHandler *event_handler, AudienceWindowCompletionHandler on_complete, void *context)
 {
-  // validate thread binding
-  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC_VOID(audience_window_post_message, handle, message));
+  return audience_context_window_create_async(nullptr, details, event_handler, on_complete, context);
+}
 
-  // ensure initialization
-  if (!audience_is_initialized.load() || audience_is_shutdown.load())
+static inline void shell_animation_end(AudienceWindowHandle handle, bool completed)
+{
+  auto ia = shell_animations.find(handle);
+  if (ia == shell_animations.end())
   {
-    SPDLOG_DEBUG("cannot call api in unitialized state");
     return;
   }
-
-  // delegate post message to nucleus, in case protocol demands
-  if (shell_protocol_negotiation.nucleus_handles_messaging)
+  auto animation = ia->second;
+  shell_animations.erase(ia);
+  SPDLOG_DEBUG("animation of window {} {}", handle, completed ? "completed" : "interrupted");
+  if (animation.on_end != nullptr)
   {
-    SPDLOG_DEBUG("delegate post message to nucleus");
-    return nucleus_window_post_message(handle, message);
+    animation.on_end(handle, animation.context, completed);
   }
+}
 
-  // post message
-  auto iws = shell_webserver_registry.left.find(handle);
-  if (iws != shell_webserver_registry.left.end())
+static inline void shell_unsafe_animation_step(void *id)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING_THROW;
+
+  // find animation, ended animations leave their last step behind
+  auto ia = std::find_if(shell_animations.begin(), shell_animations.end(), [id](auto &entry) { return entry.second.id == reinterpret_cast<uintptr_t>(id); });
+  if (ia == shell_animations.end() || audience_is_shutdown.load())
+  {
+    return;
+  }
+  auto handle = ia->first;
+  auto &animation = ia->second;
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - animation.start;
+  std::chrono::duration<double> duration = animation.duration;
+  auto t = duration.count() > 0 ? elapsed.count() / duration.count() : 1.0;
+  if (t < 1.0)
+  {
+    nucleus_window_update_position(handle, easing_interpolate(animation.from, animation.to, animation.easing, t));
+    nucleus_dispatch_after(1000 / 60, SAFE_FN(shell_unsafe_animation_step), id);
+    return;
+  }
+
+  nucleus_window_update_position(handle, animation.to);
+  shell_animation_end(handle, true);
+}
+
+static inline void shell_unsafe_window_animate(AudienceWindowHandle handle, AudienceRect target, uint32_t duration_ms, AudienceEasing easing, AudienceWindowAnimationHandler on_end, void *context)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC_VOID(audience_window_animate, handle, target, duration_ms, easing, on_end, context));
+
+  // ensure initialization
+  if (!audience_is_initialized.load() || audience_is_shutdown.load() || shell_windows.find(handle) == nullptr)
+  {
+    SPDLOG_DEBUG("cannot animate window in unitialized state or of unknown handle");
+    if (on_end != nullptr)
+    {
+      on_end(handle, context, false);
+    }
+    return;
+  }
+
+  // a new animation interrupts the running one
+  shell_animation_end(handle, false);
+
+  auto id = shell_animation_next_id++;
+  shell_animations[handle] = ShellAnimation{on_end, context, id, std::chrono::steady_clock::now(), std::chrono::milliseconds(duration_ms), target, target, easing};
+
+  // nucleus animates on its own frame clock
+  if (nucleus_window_animate != nullptr)
+  {
+    return nucleus_window_animate(handle, target, duration_ms, easing);
+  }
+
+  // otherwise step through the positions on the main loop, about once per frame, starting at the current frame
+  auto all = nucleus_window_list();
+  for (uint8_t i = 0; i < all.count; ++i)
+  {
+    if (all.windows[i].handle == handle)
+    {
+      shell_animations[handle].from = all.windows[i].frame;
+    }
+  }
+  shell_unsafe_animation_step(reinterpret_cast<void *>(id));
+}
+
+void audience_window_animate(AudienceWindowHandle handle, AudienceRect target, uint32_t duration_ms, AudienceEasing easing, AudienceWindowAnimationHandler on_end, void *context)
+{
+  return SAFE_FN(shell_unsafe_window_animate)(handle, target, duration_ms, easing, on_end, context);
+}
+
+static inline void shell_unsafe_window_update_position(AudienceWindowHandle handle, AudienceRect position)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC_VOID(audience_window_update_position, handle, position));
+
+  // ensure initialization
+  if (!audience_is_initialized.load() || audience_is_shutdown.load())
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    return;
+  }
+
+  // update window position, interrupts a running animation
+  shell_animation_end(handle, false);
+  return nucleus_window_update_position(handle, position);
+}
+
+void audience_window_update_position(AudienceWindowHandle handle, AudienceRect position)
+{
+  return SAFE_FN(shell_unsafe_window_update_position)(handle, position);
+}
+
+static inline void shell_unsafe_window_update_position_async(AudienceWindowHandle handle, AudienceRect position, AudienceWindowCompletionHandler on_complete, void *context)
+{
+  auto dispatched = shell_dispatch_async_function([=]() {
+    audience_window_update_position(handle, position);
+    if (on_complete != nullptr)
+    {
+      on_complete(handle, context);
+    }
+  });
+
+  if (!dispatched)
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    if (on_complete != nullptr)
+    {
+      on_complete(handle, context);
+    }
+  }
+}
+
+void audience_window_update_position_async(AudienceWindowHandle handle, AudienceRect position, AudienceWindowCompletionHandler on_complete, void *context)
+{
+  return SAFE_FN(shell_unsafe_window_update_position_async)(handle, position, on_complete, context);
+}
+
+static inline WebserverContext shell_webserver_lookup(AudienceWindowHandle handle)
+{
+  // callable from any thread
+  std::shared_lock<std::shared_mutex> lock(shell_webserver_registry_mutex);
+  auto window = shell_windows.find(handle);
+  return window != nullptr ? window->webserver : WebserverContext{};
+}
+
+static inline bool shell_transport_is_thread_safe()
+{
+  // the webserver accepts messages from any thread, a nucleus handling messaging requires the main thread
+  return audience_is_initialized.load() && !shell_protocol_negotiation.nucleus_handles_messaging;
+}
+
+static inline void shell_unsafe_route_message_utf8(AudienceWindowHandle handle, const char *message, size_t length)
+{
+  // delegate post message to nucleus, in case protocol demands
+  if (shell_protocol_negotiation.nucleus_handles_messaging)
+  {
+    SPDLOG_DEBUG("delegate post message to nucleus");
+    return nucleus_window_post_message(handle, utf8_to_utf16(std::string(message, length)).c_str());
+  }
+
+  // post message
+  auto ws = shell_webserver_lookup(handle);
+  if (ws)
+  {
+    SPDLOG_DEBUG("posting message to frontend");
+    return webserver_post_message(ws, std::string_view(message, length));
+  }
+  else
+  {
+    SPDLOG_ERROR("could not find webserver for window handle");
+    return;
+  }
+}
+
+static inline void shell_unsafe_window_post_message_utf8(AudienceWindowHandle handle, const char *message, size_t length)
+{
+  // hand message to the transport directly, without a round trip to the main thread
+  if (shell_transport_is_thread_safe())
+  {
+    if (audience_is_shutdown.load())
+    {
+      SPDLOG_DEBUG("cannot call api in unitialized state");
+      return;
+    }
+    return shell_unsafe_route_message_utf8(handle, message, length);
+  }
+
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC_VOID(audience_window_post_message_utf8, handle, message, length));
+
+  // ensure initialization
+  if (!audience_is_initialized.load() || audience_is_shutdown.load())
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    return;
+  }
+
+  return shell_unsafe_route_message_utf8(handle, message, length);
+}
+
+void audience_window_post_message_utf8(AudienceWindowHandle handle, const char *message, size_t length)
+{
+  return SAFE_FN(shell_unsafe_window_post_message_utf8)(handle, message, length);
+}
+
+static inline void shell_unsafe_window_post_messages(const AudienceMessageBatch *batch)
+{
+  // validate thread binding, the whole batch is dispatched at once (unless the transport takes it directly)
+  if (!shell_transport_is_thread_safe())
+  {
+    SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC_VOID(audience_window_post_messages, batch));
+  }
+
+  // ensure initialization
+  if (!audience_is_initialized.load() || audience_is_shutdown.load())
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    return;
+  }
+
+  if (batch == nullptr || (batch->messages == nullptr && batch->count > 0))
+  {
+    throw std::invalid_argument("batch must not be null");
+  }
+
+  // route messages in order, a failing message does not affect the others
+  for (size_t i = 0; i < batch->count; ++i)
+  {
+    auto &message = batch->messages[i];
+    SAFE_FN(shell_unsafe_route_message_utf8)(message.handle, message.message, message.length);
+  }
+}
+
+void audience_window_post_messages(const AudienceMessageBatch *batch)
+{
+  return SAFE_FN(shell_unsafe_window_post_messages)(batch);
+}
+
+static inline void shell_unsafe_window_post_message(AudienceWindowHandle handle, const wchar_t *message)
+{
+  // validate thread binding, not required if the transport takes the message directly
+  if (!shell_transport_is_thread_safe())
+  {
+    SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC_VOID(audience_window_post_message, handle, message));
+  }
+
+  // ensure initialization
+  if (!audience_is_initialized.load() || audience_is_shutdown.load())
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    return;
+  }
+
+  // delegate post message to nucleus, in case protocol demands
+  if (shell_protocol_negotiation.nucleus_handles_messaging)
+  {
+    SPDLOG_DEBUG("delegate post message to nucleus");
+    return nucleus_window_post_message(handle, message);
+  }
+
+  // transcode once and continue on the utf-8 path
+  auto utf8 = utf16_to_utf8(message);
+  return shell_unsafe_window_post_message_utf8(handle, utf8.data(), utf8.size());
+}
+
+void audience_window_post_message(AudienceWindowHandle handle, const wchar_t *message)
+{
+  return SAFE_FN(shell_unsafe_window_post_message)(handle, message);
+}
+
+static inline void shell_unsafe_window_post_binary(AudienceWindowHandle handle, const void *data, size_t length)
+{
+  // validate thread binding, not required if the transport takes the message directly
+  if (!shell_transport_is_thread_safe())
+  {
+    SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC_VOID(audience_window_post_binary, handle, data, length));
+  }
+
+  // ensure initialization
+  if (!audience_is_initialized.load() || audience_is_shutdown.load())
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    return;
+  }
+
+  // binary messages are transported by the webserver only
+  if (shell_protocol_negotiation.nucleus_handles_messaging)
+  {
+    SPDLOG_ERROR("binary messages are not supported by nucleus");
+    return;
+  }
+
+  // post binary message
+  auto ws = shell_webserver_lookup(handle);
+  if (ws)
+  {
+    SPDLOG_DEBUG("posting binary message to frontend");
+    return webserver_post_binary(ws, data, length);
+  }
+  else
+  {
+    SPDLOG_ERROR("could not find webserver for window handle");
+    return;
+  }
+}
+
+void audience_window_post_binary(AudienceWindowHandle handle, const void *data, size_t length)
+{
+  return SAFE_FN(shell_unsafe_window_post_binary)(handle, data, length);
+}
+
+static inline void shell_unsafe_state_flush(void * /* unused */)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING_THROW;
+
+  // ship all changes of this tick
+  shell_state_flush_scheduled = false;
+  for (auto handle : shell_state_dirty)
+  {
+    auto window = shell_windows.find(handle);
+    if (window != nullptr && window->webserver)
+    {
+      webserver_state_flush(window->webserver);
+    }
+  }
+  shell_state_dirty.clear();
+}
+
+static inline void shell_unsafe_state_update(AudienceWindowHandle handle, const char *path, const char *value)
+{
+  // state is synchronized by the webserver only
+  if (shell_protocol_negotiation.nucleus_handles_messaging)
+  {
+    SPDLOG_ERROR("state synchronization is not supported by nucleus");
+    return;
+  }
+
+  // update state
+  auto window = shell_windows.find(handle);
+  if (window == nullptr || !window->webserver)
+  {
+    SPDLOG_ERROR("could not find webserver for window handle");
+    return;
+  }
+
+  if (value != nullptr)
+  {
+    webserver_state_set(window->webserver, path, value);
+  }
+  else
+  {
+    webserver_state_remove(window->webserver, path);
+  }
+
+  // batch changes until the next iteration of the main loop
+  shell_state_dirty.insert(handle);
+  if (!shell_state_flush_scheduled)
+  {
+    shell_state_flush_scheduled = true;
+    nucleus_dispatch_async.load()(SAFE_FN(shell_unsafe_state_flush), nullptr);
+  }
+}
+
+static inline void shell_unsafe_state_set(AudienceWindowHandle handle, const char *path, const char *value)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC_VOID(audience_state_set, handle, path, value));
+
+  // ensure initialization
+  if (!audience_is_initialized.load() || audience_is_shutdown.load())
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    return;
+  }
+
+  if (path == nullptr || value == nullptr)
+  {
+    throw std::invalid_argument("path and value must not be null");
+  }
+
+  return shell_unsafe_state_update(handle, path, value);
+}
+
+void audience_state_set(AudienceWindowHandle handle, const char *path, const char *value)
+{
+  return SAFE_FN(shell_unsafe_state_set)(handle, path, value);
+}
+
+static inline void shell_unsafe_state_remove(AudienceWindowHandle handle, const char *path)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC_VOID(audience_state_remove, handle, path));
+
+  // ensure initialization
+  if (!audience_is_initialized.load() || audience_is_shutdown.load())
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    return;
+  }
+
+  if (path == nullptr)
+  {
+    throw std::invalid_argument("path must not be null");
+  }
+
+  return shell_unsafe_state_update(handle, path, nullptr);
+}
+
+void audience_state_remove(AudienceWindowHandle handle, const char *path)
+{
+  return SAFE_FN(shell_unsafe_state_remove)(handle, path);
+}
+
+typedef decltype(AudienceBlobDetails::on_release) ShellBlobRelease;
+
+static inline void shell_blob_release(ShellBlobRelease on_release)
+{
+  // blobs go away on whatever thread served them last, release on the main thread while it still runs tasks
+  auto on_main_thread = shell_thread_binding_id.load(std::memory_order_acquire) == std::this_thread::get_id();
+  if (on_main_thread || audience_is_shutdown.load() || !shell_dispatch_async_function([on_release]() { on_release.handler(on_release.context); }))
+  {
+    on_release.handler(on_release.context);
+  }
+}
+
+static inline AudienceBlobUrl shell_unsafe_window_publish_blob(AudienceWindowHandle handle, const AudienceBlobDetails *details)
+{
+  // validate thread binding, the release handler has to fire even if the call never reaches the main thread
+  SHELL_CHECK_THREAD_BINDING({
+    AudienceBlobUrl return_value{};
+    auto dispatched = false;
+    auto task_lambda = [&]() { dispatched = true; return_value = audience_window_publish_blob(handle, details); };
+    auto task = [](void *context) { (*static_cast<decltype(task_lambda) *>(context))(); };
+    auto ds = nucleus_dispatch_sync.load();
+    if (ds != nullptr)
+    {
+      SPDLOG_INFO("dispatching {} to main thread", "audience_window_publish_blob");
+      ds(task, &task_lambda);
+    }
+    if (!dispatched)
+    {
+      SPDLOG_WARN("could not dispatch {} to main thread", "audience_window_publish_blob");
+      if (details != nullptr && details->on_release.handler != nullptr)
+      {
+        shell_blob_release(details->on_release);
+      }
+    }
+    return return_value;
+  });
+
+  if (details == nullptr || (details->data == nullptr && details->length > 0))
+  {
+    throw std::invalid_argument("blob details must not be null");
+  }
+
+  // the release handler fires whenever the blob goes away, including all failures below
+  auto on_release = details->on_release;
+  auto blob = std::make_shared<WebserverBlob>();
+  blob->data = details->data;
+  blob->length = details->length;
+  blob->mime_type = details->mime_type != nullptr ? details->mime_type : "application/octet-stream";
+  if (on_release.handler != nullptr)
+  {
+    blob->release = [on_release]() { shell_blob_release(on_release); };
+  }
+
+  // ensure initialization
+  if (!audience_is_initialized.load() || audience_is_shutdown.load())
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    return AudienceBlobUrl{};
+  }
+
+  // blobs are served by the webserver only
+  if (shell_protocol_negotiation.nucleus_handles_messaging)
+  {
+    SPDLOG_ERROR("blobs are not supported by nucleus");
+    return AudienceBlobUrl{};
+  }
+
+  auto window = shell_windows.find(handle);
+  if (window == nullptr || !window->webserver)
+  {
+    SPDLOG_ERROR("could not find webserver for window handle");
+    return AudienceBlobUrl{};
+  }
+
+  auto url = webserver_blob_publish(window->webserver, std::move(blob));
+
+  AudienceBlobUrl result{};
+  url.copy(result.url, sizeof(result.url) - 1);
+  return result;
+}
+
+AudienceBlobUrl audience_window_publish_blob(AudienceWindowHandle handle, const AudienceBlobDetails *details)
+{
+  return SAFE_FN(shell_unsafe_window_publish_blob, SAFE_FN_DEFAULT(AudienceBlobUrl))(handle, details);
+}
+
+static inline void shell_unsafe_window_revoke_blob(AudienceWindowHandle handle, const char *url)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC_VOID(audience_window_revoke_blob, handle, url));
+
+  // ensure initialization
+  if (!audience_is_initialized.load() || audience_is_shutdown.load())
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    return;
+  }
+
+  if (url == nullptr)
+  {
+    throw std::invalid_argument("url must not be null");
+  }
+
+  auto window = shell_windows.find(handle);
+  if (window == nullptr || !window->webserver)
+  {
+    SPDLOG_ERROR("could not find webserver for window handle");
+    return;
+  }
+
+  return webserver_blob_revoke(window->webserver, url);
+}
+
+void audience_window_revoke_blob(AudienceWindowHandle handle, const char *url)
+{
+  return SAFE_FN(shell_unsafe_window_revoke_blob)(handle, url);
+}
+
+static inline void shell_unsafe_context_publish(AudienceContext app_context, const char *topic, const char *message, size_t length)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC_VOID(audience_context_publish, app_context, topic, message, length));
+
+  // ensure initialization
+  if (!audience_is_initialized.load() || audience_is_shutdown.load())
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    return;
+  }
+
+  if (topic == nullptr)
   {
-    SPDLOG_DEBUG("posting message to frontend");
-    return webserver_post_message(iws->second, std::wstring(message));
+    throw std::invalid_argument("topic must not be null");
   }
-  else
+
+  // subscriptions are managed by the webserver only
+  if (shell_protocol_negotiation.nucleus_handles_messaging)
   {
-    SPDLOG_ERROR("could not find webserver for window handle");
+    SPDLOG_ERROR("publish/subscribe is not supported by nucleus");
     return;
   }
+
+  // fan out to subscribers of all windows of the context
+  auto owner = shell_context_resolve(app_context);
+  std::vector<WebserverContext> contexts;
+  contexts.reserve(shell_windows.size());
+  shell_windows.for_each([&](AudienceWindowHandle, ShellWindow &window) {
+    if (window.webserver && window.owner == owner)
+    {
+      contexts.push_back(window.webserver);
+    }
+  });
+  return webserver_publish(contexts, topic, std::string_view(message, length));
 }
 
-void audience_window_post_message(AudienceWindowHandle handle, const wchar_t *message)
+void audience_context_publish(AudienceContext app_context, const char *topic, const char *message, size_t length)
 {
-  return SAFE_FN(shell_unsafe_window_post_message)(handle, message);
+  return SAFE_FN(shell_unsafe_context_publish)(app_context, topic, message, length);
+}
+
+void audience_publish(const char *topic, const char *message, size_t length)
+{
+  return audience_context_publish(nullptr, topic, message, length);
+}
+
+static inline void shell_unsafe_timer_handler(void (*handler)(AudienceTimerHandle handle, void *context), AudienceTimerHandle handle, void *context)
+{
+  handler(handle, context);
+}
+
+static inline void shell_unsafe_timer_wakeup(void *generation);
+
+static inline void shell_unsafe_timer_arm()
+{
+  if (shell_timers.empty())
+  {
+    return;
+  }
+
+  auto earliest = std::min_element(shell_timers.begin(), shell_timers.end(), [](auto &a, auto &b) { return a.second.deadline < b.second.deadline; })->second.deadline;
+
+  // a single wakeup serves all timers, an earlier deadline supersedes the pending wakeup
+  if (shell_timer_armed && shell_timer_wakeup <= earliest)
+  {
+    return;
+  }
+  shell_timer_armed = true;
+  shell_timer_wakeup = earliest;
+  shell_timer_generation += 1;
+
+  auto delay = std::chrono::ceil<std::chrono::milliseconds>(std::max(earliest - std::chrono::steady_clock::now(), std::chrono::steady_clock::duration::zero()));
+  nucleus_dispatch_after(static_cast<uint32_t>(delay.count()), SAFE_FN(shell_unsafe_timer_wakeup), reinterpret_cast<void *>(shell_timer_generation));
+}
+
+static inline void shell_unsafe_timer_wakeup(void *generation)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING_THROW;
+
+  // ignore superseded wakeups
+  if (reinterpret_cast<uintptr_t>(generation) != shell_timer_generation)
+  {
+    return;
+  }
+  shell_timer_armed = false;
+
+  if (audience_is_shutdown.load())
+  {
+    return;
+  }
+
+  // coalesce timers which are due within a tenth of their interval
+  auto now = std::chrono::steady_clock::now();
+  std::vector<AudienceTimerHandle> due;
+  for (auto &entry : shell_timers)
+  {
+    if (entry.second.deadline <= now + entry.second.interval / 10)
+    {
+      due.push_back(entry.first);
+    }
+  }
+
+  for (auto handle : due)
+  {
+    // handlers may stop any timer
+    auto it = shell_timers.find(handle);
+    if (it == shell_timers.end())
+    {
+      continue;
+    }
+    auto &timer = it->second;
+
+    // schedule relative to the previous deadline to avoid drift, missed ticks are coalesced into this one
+    timer.deadline += timer.interval;
+    if (timer.deadline <= now)
+    {
+      timer.deadline += ((now - timer.deadline) / timer.interval + 1) * timer.interval;
+    }
+
+    SAFE_FN(shell_unsafe_timer_handler)(timer.handler, handle, timer.context);
+  }
+
+  shell_unsafe_timer_arm();
+}
+
+static inline AudienceTimerHandle shell_unsafe_context_timer_start(AudienceContext app_context, uint32_t interval_ms, void (*handler)(AudienceTimerHandle handle, void *context), void *context)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC(audience_context_timer_start, AudienceTimerHandle, app_context, interval_ms, handler, context));
+
+  // ensure initialization
+  if (!audience_is_initialized.load() || audience_is_shutdown.load())
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    return AudienceTimerHandle{};
+  }
+
+  if (interval_ms == 0 || handler == nullptr)
+  {
+    throw std::invalid_argument("timer needs a handler and a positive interval");
+  }
+
+  // timers are stopped together with their context
+  auto owner = shell_context_resolve(app_context);
+
+  // allocate handle (we use defined overflow behaviour from unsigned data type here)
+  auto handle = shell_timer_next_handle++;
+  while (shell_timers.find(handle) != shell_timers.end() || handle == AudienceTimerHandle{})
+  {
+    handle = shell_timer_next_handle++;
+  }
+
+  auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::milliseconds(interval_ms));
+  shell_timers[handle] = ShellTimer{interval, std::chrono::steady_clock::now() + interval, handler, context, owner.get()};
+  SPDLOG_DEBUG("timer {} started with interval of {} ms", handle, interval_ms);
+
+  shell_unsafe_timer_arm();
+  return handle;
+}
+
+AudienceTimerHandle audience_context_timer_start(AudienceContext app_context, uint32_t interval_ms, void (*handler)(AudienceTimerHandle handle, void *context), void *context)
+{
+  return SAFE_FN(shell_unsafe_context_timer_start, SAFE_FN_DEFAULT(AudienceTimerHandle))(app_context, interval_ms, handler, context);
+}
+
+AudienceTimerHandle audience_timer_start(uint32_t interval_ms, void (*handler)(AudienceTimerHandle handle, void *context), void *context)
+{
+  return audience_context_timer_start(nullptr, interval_ms, handler, context);
+}
+
+static inline void shell_unsafe_timer_stop(AudienceTimerHandle handle)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING(SHELL_DISPATCH_SYNC_VOID(audience_timer_stop, handle));
+
+  // a pending wakeup finds nothing to do, if this was the last timer
+  if (shell_timers.erase(handle) > 0)
+  {
+    SPDLOG_DEBUG("timer {} stopped", handle);
+  }
+}
+
+void audience_timer_stop(AudienceTimerHandle handle)
+{
+  return SAFE_FN(shell_unsafe_timer_stop)(handle);
 }
 
 static inline void shell_unsafe_window_destroy(AudienceWindowHandle handle)
@@ -535,6 +1707,31 @@ void audience_window_destroy(AudienceWindowHandle handle)
   return SAFE_FN(shell_unsafe_window_destroy)(handle);
 }
 
+static inline void shell_unsafe_window_destroy_async(AudienceWindowHandle handle, AudienceWindowCompletionHandler on_complete, void *context)
+{
+  auto dispatched = shell_dispatch_async_function([=]() {
+    audience_window_destroy(handle);
+    if (on_complete != nullptr)
+    {
+      on_complete(handle, context);
+    }
+  });
+
+  if (!dispatched)
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    if (on_complete != nullptr)
+    {
+      on_complete(handle, context);
+    }
+  }
+}
+
+void audience_window_destroy_async(AudienceWindowHandle handle, AudienceWindowCompletionHandler on_complete, void *context)
+{
+  return SAFE_FN(shell_unsafe_window_destroy_async)(handle, on_complete, context);
+}
+
 static inline void shell_unsafe_quit()
 {
   // validate thread binding
@@ -579,68 +1776,329 @@ void audience_main()
   return SAFE_FN(shell_unsafe_main)();
 }
 
+static int shell_embedded_loop_none = -1;
+
+static inline int shell_unsafe_get_event_fd()
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING_THROW;
+
+  // ensure initialization
+  if (!audience_is_initialized.load())
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    return -1;
+  }
+
+  if (nucleus_event_fd == nullptr)
+  {
+    SPDLOG_WARN("embedded event loop is not supported by nucleus");
+    return -1;
+  }
+
+  return nucleus_event_fd();
+}
+
+int audience_get_event_fd()
+{
+  return SAFE_FN(shell_unsafe_get_event_fd, &shell_embedded_loop_none)();
+}
+
+static inline int shell_unsafe_poll(int timeout_ms)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING_THROW;
+
+  // ensure initialization, keep pumping after audience_quit() until on_quit got delivered
+  if (!audience_is_initialized.load())
+  {
+    SPDLOG_DEBUG("cannot call api in unitialized state");
+    return -1;
+  }
+
+  if (nucleus_poll == nullptr)
+  {
+    SPDLOG_WARN("embedded event loop is not supported by nucleus");
+    return -1;
+  }
+
+  return nucleus_poll(timeout_ms);
+}
+
+int audience_poll(int timeout_ms)
+{
+  return SAFE_FN(shell_unsafe_poll, &shell_embedded_loop_none)(timeout_ms);
+}
+
+static inline bool shell_deliver_to_pool(ShellEventPool &pool, AudienceWindowHandle handle, const AudienceWindowEventHandler &event_handler, bool binary, std::string data, bool wait)
+{
+  auto posted = pool.post(
+      handle, [handle, event_handler, binary, data = std::move(data)]() {
+        if (binary)
+        {
+          if (event_handler.on_binary.handler != nullptr)
+          {
+            event_handler.on_binary.handler(handle, event_handler.on_binary.context, data.data(), data.size());
+          }
+        }
+        else if (event_handler.on_message_utf8.handler != nullptr)
+        {
+          event_handler.on_message_utf8.handler(handle, event_handler.on_message_utf8.context, data.data(), data.size());
+        }
+        else if (event_handler.on_message.handler != nullptr)
+        {
+          event_handler.on_message.handler(handle, event_handler.on_message.context, utf8_to_utf16(data).c_str());
+        }
+      },
+      wait);
+  if (!posted)
+  {
+    SPDLOG_ERROR("event queue of window {} is full or closed, dropping message", handle);
+  }
+  return posted;
+}
+
+static inline bool shell_deliver_from_webserver(WebserverContext context, bool binary, std::string_view data)
+{
+  // called on a webserver thread, waiting for a full queue holds back further reads of the transport
+  ShellPoolWindow entry;
+  {
+    std::lock_guard<std::mutex> lock(shell_event_pool_windows_mutex);
+    auto i = shell_event_pool_windows.find(context);
+    if (i == shell_event_pool_windows.end())
+    {
+      return false;
+    }
+    entry = i->second;
+  }
+  shell_deliver_to_pool(entry.owner->event_pool, entry.handle, entry.event_handler, binary, std::string(data), true);
+  return true;
+}
+
 static inline void shell_unsafe_on_window_message(AudienceWindowHandle handle, const wchar_t *message)
 {
   // validate thread binding
   SHELL_CHECK_THREAD_BINDING_THROW;
 
-  // call user event handler
-  auto ehi = audience_window_event_handler.find(handle);
-  if (ehi != audience_window_event_handler.end())
+  // call user event handler, utf-8 variant takes precedence
+  auto window = shell_windows.find(handle);
+  if (window != nullptr && !window->owner->destroyed)
   {
-    if (ehi->second.on_message.handler != nullptr)
+    auto event_handler = window->event_handler;
+    if (event_handler.message_delivery == AUDIENCE_EVENT_DELIVERY_WORKER_POOL)
+    {
+      // the main thread must not wait for workers, they may call into the api
+      shell_deliver_to_pool(window->owner->event_pool, handle, event_handler, false, utf16_to_utf8(message), false);
+    }
+    else if (event_handler.on_message_utf8.handler != nullptr)
+    {
+      auto utf8 = utf16_to_utf8(message);
+      event_handler.on_message_utf8.handler(
+          handle,
+          event_handler.on_message_utf8.context,
+          utf8.data(),
+          utf8.size());
+    }
+    else if (event_handler.on_message.handler != nullptr)
     {
-      ehi->second.on_message.handler(
+      event_handler.on_message.handler(
           handle,
-          ehi->second.on_message.context,
+          event_handler.on_message.context,
           message);
     }
   }
 }
 
+static inline void shell_unsafe_on_window_message_utf8(AudienceWindowHandle handle, const char *message, size_t length)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING_THROW;
+
+  // call user event handler, wide variant only in case no utf-8 handler is registered
+  auto window = shell_windows.find(handle);
+  if (window != nullptr && !window->owner->destroyed)
+  {
+    auto event_handler = window->event_handler;
+    if (event_handler.message_delivery == AUDIENCE_EVENT_DELIVERY_WORKER_POOL)
+    {
+      shell_deliver_to_pool(window->owner->event_pool, handle, event_handler, false, std::string(message, length), false);
+    }
+    else if (event_handler.on_message_utf8.handler != nullptr)
+    {
+      event_handler.on_message_utf8.handler(
+          handle,
+          event_handler.on_message_utf8.context,
+          message,
+          length);
+    }
+    else if (event_handler.on_message.handler != nullptr)
+    {
+      event_handler.on_message.handler(
+          handle,
+          event_handler.on_message.context,
+          utf8_to_utf16(std::string(message, length)).c_str());
+    }
+  }
+}
+
+static inline void shell_unsafe_on_window_binary(AudienceWindowHandle handle, const void *data, size_t length)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING_THROW;
+
+  // call user event handler
+  auto window = shell_windows.find(handle);
+  if (window != nullptr && !window->owner->destroyed)
+  {
+    auto event_handler = window->event_handler;
+    if (event_handler.message_delivery == AUDIENCE_EVENT_DELIVERY_WORKER_POOL)
+    {
+      shell_deliver_to_pool(window->owner->event_pool, handle, event_handler, true, std::string(static_cast<const char *>(data), length), false);
+    }
+    else if (event_handler.on_binary.handler != nullptr)
+    {
+      event_handler.on_binary.handler(
+          handle,
+          event_handler.on_binary.context,
+          data,
+          length);
+    }
+  }
+}
+
+static inline void shell_unsafe_on_window_resync(AudienceWindowHandle handle)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING_THROW;
+
+  // call user event handler
+  auto window = shell_windows.find(handle);
+  if (window != nullptr && !window->owner->destroyed)
+  {
+    auto event_handler = window->event_handler;
+    if (event_handler.on_resync.handler != nullptr)
+    {
+      event_handler.on_resync.handler(
+          handle,
+          event_handler.on_resync.context);
+    }
+  }
+}
+
 static inline void shell_unsafe_on_window_close_intent(AudienceWindowHandle handle)
 {
   // validate thread binding
   SHELL_CHECK_THREAD_BINDING_THROW;
 
   // call user event handler
-  auto ehi = audience_window_event_handler.find(handle);
-  if (ehi != audience_window_event_handler.end())
+  auto window = shell_windows.find(handle);
+  if (window != nullptr && !window->owner->destroyed)
+  {
+    auto event_handler = window->event_handler;
+    if (event_handler.on_close_intent.handler != nullptr)
+    {
+      event_handler.on_close_intent.handler(
+          handle,
+          event_handler.on_close_intent.context);
+    }
+  }
+}
+
+static inline void shell_unsafe_on_window_geometry_change(AudienceWindowHandle handle, AudienceRect frame, AudienceSize workspace)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING_THROW;
+
+  // call user event handler
+  auto window = shell_windows.find(handle);
+  if (window != nullptr && !window->owner->destroyed)
+  {
+    auto event_handler = window->event_handler;
+    if (event_handler.on_geometry_change.handler != nullptr)
+    {
+      event_handler.on_geometry_change.handler(
+          handle,
+          event_handler.on_geometry_change.context,
+          frame,
+          workspace);
+    }
+  }
+}
+
+static inline void shell_unsafe_on_window_focus_change(AudienceWindowHandle handle, bool has_focus)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING_THROW;
+
+  // call user event handler
+  auto window = shell_windows.find(handle);
+  if (window != nullptr && !window->owner->destroyed)
   {
-    if (ehi->second.on_close_intent.handler != nullptr)
+    auto event_handler = window->event_handler;
+    if (event_handler.on_focus_change.handler != nullptr)
     {
-      ehi->second.on_close_intent.handler(
+      event_handler.on_focus_change.handler(
           handle,
-          ehi->second.on_close_intent.context);
+          event_handler.on_focus_change.context,
+          has_focus);
     }
   }
 }
 
+static inline void shell_unsafe_on_window_animation_complete(AudienceWindowHandle handle)
+{
+  // validate thread binding
+  SHELL_CHECK_THREAD_BINDING_THROW;
+
+  shell_animation_end(handle, true);
+}
+
 static inline void shell_unsafe_on_window_close(AudienceWindowHandle handle, bool is_last_window)
 {
   // validate thread binding
   SHELL_CHECK_THREAD_BINDING_THROW;
 
+  // a closing window interrupts its animation
+  shell_animation_end(handle, false);
+
+  // stop delivering to the worker pool, pending events are dropped and blocked transport reads released
+  auto window = shell_windows.find(handle);
+  if (window != nullptr && window->event_handler.message_delivery == AUDIENCE_EVENT_DELIVERY_WORKER_POOL)
+  {
+    if (window->webserver)
+    {
+      std::lock_guard<std::mutex> lock(shell_event_pool_windows_mutex);
+      shell_event_pool_windows.erase(window->webserver);
+    }
+    window->owner->event_pool.close(handle);
+  }
+
   // call user event handler
-  auto ehi = audience_window_event_handler.find(handle);
-  if (ehi != audience_window_event_handler.end())
+  if (window != nullptr && !window->owner->destroyed)
   {
-    if (ehi->second.on_close.handler != nullptr)
+    auto event_handler = window->event_handler;
+    if (event_handler.on_close.handler != nullptr)
     {
-      ehi->second.on_close.handler(
+      event_handler.on_close.handler(
           handle,
-          ehi->second.on_close.context,
+          event_handler.on_close.context,
           is_last_window);
     }
   }
 
-  // check if we have to stop a running webservice
-  auto wsi = shell_webserver_registry.left.find(handle);
-  if (wsi != shell_webserver_registry.left.end())
+  // release window and check if we have to stop a running webservice
+  // (looked up again, handler may have created windows meanwhile)
+  if (auto released = shell_windows.find(handle); released != nullptr)
   {
-    auto ws = wsi->second;
-    shell_webserver_registry.left.erase(wsi);
-    webserver_stop(ws);
+    auto ws = released->webserver;
+    {
+      std::unique_lock<std::shared_mutex> lock(shell_webserver_registry_mutex);
+      shell_windows.erase(handle);
+    }
+    if (ws)
+    {
+      webserver_stop(ws);
+    }
   }
 }
 
@@ -653,10 +2111,22 @@ static inline void shell_unsafe_on_app_quit()
   // nucleus_dispatch_sync = nullptr;
   // nucleus_dispatch_async = nullptr;
 
-  // call user event handler
-  if (audience_app_event_handler.on_quit.handler != nullptr)
+  // drop pending events of worker pools
+  std::vector<ShellContext> contexts;
+  for (auto &entry : shell_contexts)
+  {
+    entry.second->event_pool.stop();
+    contexts.push_back(entry.second);
+  }
+
+  // call user event handler of every context
+  for (auto &context : contexts)
   {
-    audience_app_event_handler.on_quit.handler(
-        audience_app_event_handler.on_quit.context);
+    auto event_handler = context->event_handler;
+    if (event_handler.on_quit.handler != nullptr)
+    {
+      event_handler.on_quit.handler(
+          event_handler.on_quit.context);
+    }
   }
 }
@@ -14,3 +14,7 @@ typedef void (*nucleus_quit_t)();
 typedef void (*nucleus_main_t)();
 typedef void (*nucleus_dispatch_sync_t)(void (*task)(void *context), void *context);
 typedef void (*nucleus_dispatch_async_t)(void (*task)(void *context), void *context);
+typedef void (*nucleus_dispatch_after_t)(uint32_t delay_ms, void (*task)(void *context), void *context);
+typedef int (*nucleus_event_fd_t)();
+typedef int (*nucleus_poll_t)(int timeout_ms);
+typedef void (*nucleus_window_animate_t)(AudienceWindowHandle handle, AudienceRect target, uint32_t duration_ms, AudienceEasing easing);
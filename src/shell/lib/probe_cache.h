@@ -0,0 +1,291 @@
+#pragma once
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <functional>
+#include <chrono>
+#include <random>
+#include <spdlog/spdlog.h>
+
+#include "../../common/utf.h"
+
+// Remembers nucleus libraries which failed to load across launches:
+// - entries are keyed by library path and only apply while modification time, size and display environment match
+// - libraries which failed are deferred behind all others, the priority order is kept otherwise
+// - failures expire after a day, as they may stem from missing runtimes installed meanwhile (e.g. webview2),
+//   and are forgotten once the library loads
+// - the cache lives in the per user cache directory, one file per application directory
+// - setting AUDIENCE_NUCLEUS_PROBE_CACHE=0 disables the cache
+class ShellProbeCache
+{
+  // outcome field of the file format, loaded libraries (1) got recorded by earlier versions and are dropped
+  static constexpr int outcome_failed = 2;
+
+  struct Entry
+  {
+    int64_t mtime = 0;
+    int64_t size = 0;
+    int64_t recorded = 0; // seconds since epoch
+    std::string environment;
+  };
+
+  static constexpr int64_t failure_lifetime = 24 * 60 * 60;
+
+  std::wstring file_;
+  std::string environment_;
+  std::map<std::string, Entry> entries_;
+  bool dirty_ = false;
+
+  static std::string getenv_string(const char *name)
+  {
+    auto value = std::getenv(name);
+    return value != nullptr ? value : "";
+  }
+
+  static int64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
+  static bool fingerprint(const std::wstring &path, int64_t &mtime, int64_t &size)
+  {
+#ifdef WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data{};
+    if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
+    {
+      return false;
+    }
+    mtime = (int64_t(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+    size = (int64_t(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+#else
+    struct stat info
+    {
+    };
+    if (stat(utf16_to_utf8(path).c_str(), &info) != 0)
+    {
+      return false;
+    }
+    mtime = int64_t(info.st_mtime);
+    size = int64_t(info.st_size);
+#endif
+    return true;
+  }
+
+  static std::wstring cache_dir()
+  {
+#ifdef WIN32
+    auto base = _wgetenv(L"LOCALAPPDATA");
+    return base != nullptr ? std::wstring(base) + L"\\audience" : std::wstring();
+#elif __APPLE__
+    auto home = getenv_string("HOME");
+    return home.empty() ? std::wstring() : utf8_to_utf16(home + "/Library/Caches/audience");
+#else
+    auto base = getenv_string("XDG_CACHE_HOME");
+    if (base.empty())
+    {
+      auto home = getenv_string("HOME");
+      if (home.empty())
+      {
+        return std::wstring();
+      }
+      base = home + "/.cache";
+    }
+    return utf8_to_utf16(base + "/audience");
+#endif
+  }
+
+  static bool make_dir(const std::wstring &dir)
+  {
+#ifdef WIN32
+    return CreateDirectoryW(dir.c_str(), nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+    // parent may be missing as well, e.g. a fresh ~/.cache
+    auto dir_utf8 = utf16_to_utf8(dir);
+    auto parent = dir_utf8.substr(0, dir_utf8.find_last_of('/'));
+    if (!parent.empty())
+    {
+      mkdir(parent.c_str(), 0700);
+    }
+    struct stat info
+    {
+    };
+    return mkdir(dir_utf8.c_str(), 0700) == 0 || (stat(dir_utf8.c_str(), &info) == 0 && S_ISDIR(info.st_mode));
+#endif
+  }
+
+  static void remove_file(const std::wstring &path)
+  {
+#ifdef WIN32
+    DeleteFileW(path.c_str());
+#else
+    std::remove(utf16_to_utf8(path).c_str());
+#endif
+  }
+
+  // the nuclei depend on the display server in use
+  static std::string display_environment()
+  {
+#if defined(WIN32) || defined(__APPLE__)
+    return "default";
+#else
+    return "session=" + getenv_string("XDG_SESSION_TYPE") +
+           ";x11=" + (getenv_string("DISPLAY").empty() ? "0" : "1") +
+           ";wayland=" + (getenv_string("WAYLAND_DISPLAY").empty() ? "0" : "1");
+#endif
+  }
+
+  Entry *lookup(const std::wstring &path, int64_t &mtime, int64_t &size)
+  {
+    if (!fingerprint(path, mtime, size))
+    {
+      return nullptr;
+    }
+    auto ie = entries_.find(utf16_to_utf8(path));
+    if (ie == entries_.end() || ie->second.mtime != mtime || ie->second.size != size || ie->second.environment != environment_)
+    {
+      return nullptr;
+    }
+    return &ie->second;
+  }
+
+public:
+  void load(const std::wstring &app_dir)
+  {
+    if (getenv_string("AUDIENCE_NUCLEUS_PROBE_CACHE") == "0")
+    {
+      SPDLOG_DEBUG("nucleus probe cache disabled");
+      return;
+    }
+
+    auto dir = cache_dir();
+    if (dir.empty())
+    {
+      return;
+    }
+
+    std::ostringstream name;
+    name << "nucleus-probe-" << std::hex << std::hash<std::wstring>{}(app_dir) << ".cache";
+#ifdef WIN32
+    file_ = dir + L"\\" + utf8_to_utf16(name.str());
+#else
+    file_ = dir + L"/" + utf8_to_utf16(name.str());
+#endif
+    environment_ = display_environment();
+
+    // format: one entry per line, "<outcome> <mtime> <size> <recorded> <environment> <path>", with outcome 2 for failures
+#ifdef WIN32
+    std::ifstream in(file_.c_str());
+#else
+    std::ifstream in(utf16_to_utf8(file_).c_str());
+#endif
+    std::string line;
+    while (std::getline(in, line))
+    {
+      std::istringstream fields(line);
+      int outcome;
+      Entry entry;
+      std::string path;
+      if (fields >> outcome >> entry.mtime >> entry.size >> entry.recorded >> entry.environment && std::getline(fields >> std::ws, path))
+      {
+        if (outcome == outcome_failed)
+        {
+          entries_[path] = entry;
+        }
+        else
+        {
+          dirty_ = true;
+        }
+      }
+    }
+    SPDLOG_DEBUG("nucleus probe cache {} loaded with {} entries", utf16_to_utf8(file_), entries_.size());
+  }
+
+  // whether the library failed recently with the same fingerprint and environment
+  bool failed(const std::wstring &path)
+  {
+    int64_t mtime, size;
+    auto entry = lookup(path, mtime, size);
+    return entry != nullptr && now() - entry->recorded <= failure_lifetime;
+  }
+
+  void record_failure(const std::wstring &path)
+  {
+    int64_t mtime = 0, size = 0;
+    if (file_.empty() || !fingerprint(path, mtime, size))
+    {
+      return;
+    }
+    entries_[utf16_to_utf8(path)] = Entry{mtime, size, now(), environment_};
+    dirty_ = true;
+  }
+
+  // called once the library loaded, a previous failure no longer applies
+  void forget(const std::wstring &path)
+  {
+    if (entries_.erase(utf16_to_utf8(path)) > 0)
+    {
+      dirty_ = true;
+    }
+  }
+
+  void save()
+  {
+    if (!dirty_ || !make_dir(cache_dir()))
+    {
+      return;
+    }
+    dirty_ = false;
+
+    // write to a temporary file first, concurrent launches must neither read partial files nor share the temporary one
+    std::wostringstream temp_name;
+#ifdef WIN32
+    temp_name << file_ << L"." << GetCurrentProcessId();
+#else
+    temp_name << file_ << L"." << getpid();
+#endif
+    temp_name << L"-" << std::hex << std::random_device{}() << L".tmp";
+    auto temp_file = temp_name.str();
+    {
+#ifdef WIN32
+      std::ofstream out(temp_file.c_str(), std::ios::trunc);
+#else
+      std::ofstream out(utf16_to_utf8(temp_file).c_str(), std::ios::trunc);
+#endif
+      for (auto &entry : entries_)
+      {
+        out << outcome_failed << " " << entry.second.mtime << " " << entry.second.size << " " << entry.second.recorded << " " << entry.second.environment << " " << entry.first << "\n";
+      }
+      out.close();
+      if (!out.good())
+      {
+        SPDLOG_WARN("could not write nucleus probe cache {}", utf16_to_utf8(temp_file));
+        remove_file(temp_file);
+        return;
+      }
+    }
+#ifdef WIN32
+    auto moved = MoveFileExW(temp_file.c_str(), file_.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    auto moved = std::rename(utf16_to_utf8(temp_file).c_str(), utf16_to_utf8(file_).c_str()) == 0;
+#endif
+    if (!moved)
+    {
+      SPDLOG_WARN("could not replace nucleus probe cache {}", utf16_to_utf8(file_));
+      remove_file(temp_file);
+    }
+  }
+};
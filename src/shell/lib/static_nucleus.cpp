@@ -0,0 +1,63 @@
+#include <cstring>
+
+#include "static_nucleus.h"
+
+// nucleus linked into the shell (see AUDIENCE_STATIC_NUCLEUS in CMakeLists.txt)
+extern "C"
+{
+  bool nucleus_init(AudienceNucleusProtocolNegotiation *negotiation, const AudienceNucleusAppDetails *details);
+  AudienceScreenList nucleus_screen_list();
+  AudienceWindowList nucleus_window_list();
+  AudienceWindowHandle nucleus_window_create(const AudienceWindowDetails *details);
+  void nucleus_window_update_position(AudienceWindowHandle handle, AudienceRect position);
+  void nucleus_window_post_message(AudienceWindowHandle handle, const wchar_t *message);
+  void nucleus_window_destroy(AudienceWindowHandle handle);
+  void nucleus_quit();
+  void nucleus_main();
+  void nucleus_dispatch_sync(void (*task)(void *context), void *context);
+  void nucleus_dispatch_async(void (*task)(void *context), void *context);
+  void nucleus_dispatch_after(uint32_t delay_ms, void (*task)(void *context), void *context);
+#if !defined(WIN32) && !defined(__APPLE__)
+  int nucleus_event_fd();
+  int nucleus_poll(int timeout_ms);
+  void nucleus_window_animate(AudienceWindowHandle handle, AudienceRect target, uint32_t duration_ms, AudienceEasing easing);
+#endif
+}
+
+static const struct
+{
+  const char *name;
+  void *function;
+} static_nucleus_table[] = {
+    {"nucleus_init", reinterpret_cast<void *>(&nucleus_init)},
+    {"nucleus_screen_list", reinterpret_cast<void *>(&nucleus_screen_list)},
+    {"nucleus_window_list", reinterpret_cast<void *>(&nucleus_window_list)},
+    {"nucleus_window_create", reinterpret_cast<void *>(&nucleus_window_create)},
+    {"nucleus_window_update_position", reinterpret_cast<void *>(&nucleus_window_update_position)},
+    {"nucleus_window_post_message", reinterpret_cast<void *>(&nucleus_window_post_message)},
+    {"nucleus_window_destroy", reinterpret_cast<void *>(&nucleus_window_destroy)},
+    {"nucleus_quit", reinterpret_cast<void *>(&nucleus_quit)},
+    {"nucleus_main", reinterpret_cast<void *>(&nucleus_main)},
+    {"nucleus_dispatch_sync", reinterpret_cast<void *>(&nucleus_dispatch_sync)},
+    {"nucleus_dispatch_async", reinterpret_cast<void *>(&nucleus_dispatch_async)},
+    {"nucleus_dispatch_after", reinterpret_cast<void *>(&nucleus_dispatch_after)},
+#if !defined(WIN32) && !defined(__APPLE__)
+    {"nucleus_event_fd", reinterpret_cast<void *>(&nucleus_event_fd)},
+    {"nucleus_poll", reinterpret_cast<void *>(&nucleus_poll)},
+    {"nucleus_window_animate", reinterpret_cast<void *>(&nucleus_window_animate)},
+#endif
+};
+
+const char *static_nucleus_library = AUDIENCE_STATIC_NUCLEUS_FILE;
+
+void *static_nucleus_lookup(const char *name)
+{
+  for (auto &entry : static_nucleus_table)
+  {
+    if (std::strcmp(entry.name, name) == 0)
+    {
+      return entry.function;
+    }
+  }
+  return nullptr;
+}
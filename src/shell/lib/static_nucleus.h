@@ -0,0 +1,9 @@
+#pragma once
+
+#include "nucleus.h"
+
+// file name of the nucleus library which is linked into the shell, e.g. "libaudience_unix_webkit.so"
+extern const char *static_nucleus_library;
+
+// resolves the exported functions of the linked nucleus by name, replaces dlsym/GetProcAddress
+void *static_nucleus_lookup(const char *name);
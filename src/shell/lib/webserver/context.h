@@ -1,10 +1,21 @@
 #pragma once
 
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <thread>
 #include <set>
+#include <vector>
+#include <unordered_map>
+#include <deque>
+#include <random>
 #include <memory>
 #include <mutex>
+#include <atomic>
+#include <functional>
+#include <json.hpp>
+#include <spdlog/spdlog.h>
+
+#include "process.h"
 
 class websocket_session;
 
@@ -18,9 +29,50 @@ struct WebserverContextData
   boost::asio::io_context ioc;
   std::vector<std::thread> threads;
 
+  // open http and websocket connections, limited by options.limits.max_connections
+  std::atomic<std::size_t> connections{0};
+
+  // periodically drops expired sessions and subscriptions
+  boost::asio::steady_timer reaper;
+
   std::set<std::weak_ptr<websocket_session>, std::owner_less<std::weak_ptr<websocket_session>>> websocket_sessions;
   std::mutex websocket_sessions_mutex;
 
+  void reap()
+  {
+    std::size_t reaped = 0;
+    {
+      std::lock_guard<std::mutex> lock(websocket_sessions_mutex);
+      for (auto i = websocket_sessions.begin(); i != websocket_sessions.end();)
+      {
+        if (i->expired())
+        {
+          i = websocket_sessions.erase(i);
+          reaped += 1;
+        }
+        else
+        {
+          ++i;
+        }
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(subscriptions_mutex);
+      for (auto i = subscriptions.begin(); i != subscriptions.end();)
+      {
+        for (auto j = i->second.begin(); j != i->second.end();)
+        {
+          j = j->expired() ? i->second.erase(j) : std::next(j);
+        }
+        i = i->second.empty() ? subscriptions.erase(i) : std::next(i);
+      }
+    }
+    if (reaped > 0)
+    {
+      SPDLOG_DEBUG("reaped {} expired websocket sessions", reaped);
+    }
+  }
+
   void add_ws_session(std::shared_ptr<websocket_session> &ws)
   {
     std::lock_guard<std::mutex> lock(websocket_sessions_mutex);
@@ -47,11 +99,123 @@ struct WebserverContextData
     return result;
   }
 
-  std::function<void(WebserverContext, const std::wstring&)> on_message_handler;
+  // topic subscriptions of sessions
+  std::unordered_map<std::string, std::set<std::weak_ptr<websocket_session>, std::owner_less<std::weak_ptr<websocket_session>>>> subscriptions;
+  std::mutex subscriptions_mutex;
+
+  void subscribe(const std::string &topic, std::shared_ptr<websocket_session> ws)
+  {
+    std::lock_guard<std::mutex> lock(subscriptions_mutex);
+    subscriptions[topic].insert(ws);
+  }
+
+  void unsubscribe(const std::string &topic, std::shared_ptr<websocket_session> ws)
+  {
+    std::lock_guard<std::mutex> lock(subscriptions_mutex);
+    auto i = subscriptions.find(topic);
+    if (i != subscriptions.end())
+    {
+      i->second.erase(ws);
+      if (i->second.empty())
+      {
+        subscriptions.erase(i);
+      }
+    }
+  }
+
+  std::vector<std::shared_ptr<websocket_session>> get_subscribers(const std::string &topic)
+  {
+    std::lock_guard<std::mutex> lock(subscriptions_mutex);
+    std::vector<std::shared_ptr<websocket_session>> result;
+    auto i = subscriptions.find(topic);
+    if (i == subscriptions.end())
+    {
+      return result;
+    }
+    for (auto j = i->second.begin(); j != i->second.end();)
+    {
+      auto is = j->lock();
+      if (is)
+      {
+        result.push_back(is);
+        ++j;
+      }
+      else
+      {
+        j = i->second.erase(j);
+      }
+    }
+    if (i->second.empty())
+    {
+      subscriptions.erase(i);
+    }
+    return result;
+  }
+
+  // blobs served without copying, looked up by id
+  struct
+  {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const WebserverBlob>> entries;
+    std::random_device random; // drawn from directly, a seeded engine would shrink the id space to its seed
+  } blobs;
 
-  WebserverContextData(int concurrency_hint)
-      : ioc(concurrency_hint)
+  std::shared_ptr<const WebserverBlob> get_blob(const std::string &id)
+  {
+    std::lock_guard<std::mutex> lock(blobs.mutex);
+    auto i = blobs.entries.find(id);
+    return i != blobs.entries.end() ? i->second : nullptr;
+  }
+
+  std::function<void(WebserverContext, std::string_view)> on_message_handler;
+  std::function<void(WebserverContext, std::string_view)> on_binary_handler;
+  std::function<void(WebserverContext)> on_resync_handler;
+
+  WebserverOptions options;
+
+  // state store, mirrored to all sessions as json patches
+  struct
+  {
+    std::mutex mutex;
+    nlohmann::json current = nlohmann::json::object();
+    nlohmann::json shipped = nlohmann::json::object();
+    uint64_t version = 0;
+  } state;
+
+  // sequenced user messages, replayed to sessions resuming after a reconnect or reload
+  struct replay_entry
+  {
+    uint64_t seq;
+    bool binary;
+    std::shared_ptr<const std::string> data;
+  };
+
+  struct
+  {
+    std::mutex mutex;
+    std::deque<replay_entry> ring;
+    std::size_t ring_bytes = 0;
+    uint64_t next_seq = 1;
+    std::string epoch;
+  } replay;
+
+  // transport statistics, updated by websocket sessions
+  struct
+  {
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> messages{0};
+    std::atomic<uint64_t> payload_bytes{0};
+    std::atomic<uint64_t> wire_bytes{0};
+    std::atomic<uint64_t> write_time_us{0};
+  } statistics;
+
+  WebserverContextData(int concurrency_hint, const WebserverOptions &options)
+      : ioc(concurrency_hint), reaper(ioc), options(options)
   {
     threads.reserve(concurrency_hint);
+
+    // sequence numbers are only meaningful within the lifetime of this context
+    std::random_device rd;
+    replay.epoch = std::to_string(rd()) + std::to_string(rd());
   }
 };
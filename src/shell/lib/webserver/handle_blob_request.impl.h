@@ -0,0 +1,191 @@
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/optional.hpp>
+#include <memory>
+#include <string>
+
+#include "process.h"
+
+// Serializes a slice of a blob straight from its memory, the body keeps the blob alive while it is being written
+struct blob_body
+{
+  struct value_type
+  {
+    std::shared_ptr<const WebserverBlob> blob;
+    std::size_t offset = 0;
+    std::size_t length = 0;
+  };
+
+  static std::uint64_t
+  size(value_type const &body)
+  {
+    return body.length;
+  }
+
+  class writer
+  {
+    value_type const &body_;
+
+  public:
+    using const_buffers_type = boost::asio::const_buffer;
+
+    template <bool isRequest, class Fields>
+    explicit writer(boost::beast::http::header<isRequest, Fields> const &, value_type const &body)
+        : body_(body)
+    {
+    }
+
+    void
+    init(boost::beast::error_code &ec)
+    {
+      ec = {};
+    }
+
+    boost::optional<std::pair<const_buffers_type, bool>>
+    get(boost::beast::error_code &ec)
+    {
+      ec = {};
+      return {{const_buffers_type(static_cast<const char *>(body_.blob->data) + body_.offset, body_.length), false}};
+    }
+  };
+};
+
+enum blob_range_result
+{
+  BLOB_RANGE_NONE,
+  BLOB_RANGE_SATISFIABLE,
+  BLOB_RANGE_UNSATISFIABLE
+};
+
+// Parses a single byte range, e.g. "bytes=0-499", "bytes=500-" or "bytes=-500"
+// (multiple ranges are not supported and answered with the whole blob)
+static inline blob_range_result blob_parse_range(boost::beast::string_view header, std::size_t size, std::size_t &offset, std::size_t &length)
+{
+  static const boost::beast::string_view unit = "bytes=";
+  if (header.size() <= unit.size() || header.substr(0, unit.size()) != unit || header.find(',') != boost::beast::string_view::npos)
+  {
+    return BLOB_RANGE_NONE;
+  }
+
+  auto spec = std::string(header.substr(unit.size()));
+  auto dash = spec.find('-');
+  if (dash == std::string::npos)
+  {
+    return BLOB_RANGE_NONE;
+  }
+
+  try
+  {
+    std::size_t first, last;
+    if (dash == 0)
+    {
+      // suffix range
+      auto suffix = std::stoull(spec.substr(1));
+      if (suffix == 0 || size == 0)
+      {
+        return BLOB_RANGE_UNSATISFIABLE;
+      }
+      first = size - std::min<std::size_t>(suffix, size);
+      last = size - 1;
+    }
+    else
+    {
+      first = std::stoull(spec.substr(0, dash));
+      last = dash + 1 < spec.size() ? std::stoull(spec.substr(dash + 1)) : size - 1;
+      if (first >= size || last < first)
+      {
+        return BLOB_RANGE_UNSATISFIABLE;
+      }
+      last = std::min<std::size_t>(last, size - 1);
+    }
+    offset = first;
+    length = last - first + 1;
+    return BLOB_RANGE_SATISFIABLE;
+  }
+  catch (const std::exception &)
+  {
+    return BLOB_RANGE_NONE;
+  }
+}
+
+// This function produces an HTTP response for a blob,
+// honoring range requests of media elements and fetch().
+template <
+    class Body, class Allocator,
+    class Send>
+void handle_blob_request(
+    std::shared_ptr<const WebserverBlob> blob,
+    boost::beast::http::request<Body, boost::beast::http::basic_fields<Allocator>> &&req,
+    Send &&send)
+{
+  // Returns an empty response of the given status
+  auto const empty_response =
+      [&req](boost::beast::http::status status) {
+        boost::beast::http::response<boost::beast::http::empty_body> res{status, req.version()};
+        res.set(boost::beast::http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.keep_alive(req.keep_alive());
+        return res;
+      };
+
+  // Make sure we can handle the method
+  if (req.method() != boost::beast::http::verb::get &&
+      req.method() != boost::beast::http::verb::head)
+  {
+    auto res = empty_response(boost::beast::http::status::bad_request);
+    res.content_length(0);
+    return send(std::move(res));
+  }
+
+  // Handle the case where the blob has been revoked
+  if (!blob)
+  {
+    auto res = empty_response(boost::beast::http::status::not_found);
+    res.content_length(0);
+    return send(std::move(res));
+  }
+
+  // Determine the requested slice
+  std::size_t offset = 0, length = blob->length;
+  auto range = blob_parse_range(req[boost::beast::http::field::range], blob->length, offset, length);
+  if (range == BLOB_RANGE_UNSATISFIABLE)
+  {
+    auto res = empty_response(boost::beast::http::status::range_not_satisfiable);
+    res.set(boost::beast::http::field::content_range, "bytes */" + std::to_string(blob->length));
+    res.content_length(0);
+    return send(std::move(res));
+  }
+
+  auto const status = range == BLOB_RANGE_SATISFIABLE ? boost::beast::http::status::partial_content : boost::beast::http::status::ok;
+  auto const prepare = [&](auto &res) {
+    res.set(boost::beast::http::field::server, BOOST_BEAST_VERSION_STRING);
+    res.set(boost::beast::http::field::content_type, blob->mime_type);
+    res.set(boost::beast::http::field::accept_ranges, "bytes");
+    // large buffers would otherwise be duplicated into the cache of the web view
+    res.set(boost::beast::http::field::cache_control, "no-store");
+    if (range == BLOB_RANGE_SATISFIABLE)
+    {
+      res.set(boost::beast::http::field::content_range,
+              "bytes " + std::to_string(offset) + "-" + std::to_string(offset + length - 1) + "/" + std::to_string(blob->length));
+    }
+    res.content_length(length);
+    res.keep_alive(req.keep_alive());
+  };
+
+  // Respond to HEAD request
+  if (req.method() == boost::beast::http::verb::head)
+  {
+    boost::beast::http::response<boost::beast::http::empty_body> res{status, req.version()};
+    prepare(res);
+    return send(std::move(res));
+  }
+
+  // Respond to GET request
+  boost::beast::http::response<blob_body> res{status, req.version()};
+  prepare(res);
+  res.body().blob = std::move(blob);
+  res.body().offset = offset;
+  res.body().length = length;
+  return send(std::move(res));
+}
@@ -6,6 +6,7 @@
 
 #include "websocket_session.impl.h"
 #include "handle_request.impl.h"
+#include "handle_blob_request.impl.h"
 
 // Handles an HTTP server connection
 class http_session : public std::enable_shared_from_this<http_session>
@@ -44,6 +45,13 @@ class http_session : public std::enable_shared_from_this<http_session>
       return items_.size() >= limit;
     }
 
+    // Returns `true` if no response is being written
+    bool
+    is_empty() const
+    {
+      return items_.empty();
+    }
+
     // Called when a message finishes sending
     // Returns `true` if the caller should initiate a read
     bool
@@ -116,11 +124,21 @@ public:
       std::shared_ptr<std::string const> const &doc_root)
       : context_(context), stream_(std::move(socket)), doc_root_(doc_root), queue_(*this)
   {
+    auto ctx = context_.lock();
+    if (ctx)
+    {
+      ctx->connections += 1;
+    }
     SPDLOG_INFO("http session created");
   }
 
   ~http_session()
   {
+    auto ctx = context_.lock();
+    if (ctx)
+    {
+      ctx->connections -= 1;
+    }
     SPDLOG_INFO("http session closed");
   }
 
@@ -139,11 +157,21 @@ private:
     parser_.emplace();
 
     // Apply a reasonable limit to the allowed size
-    // of the body in bytes to prevent abuse.
-    //parser_->body_limit(10000);
+    // of the header and body in bytes to prevent abuse.
+    auto ctx = context_.lock();
+    if (!ctx)
+    {
+      return do_close();
+    }
+    parser_->header_limit(static_cast<std::uint32_t>(ctx->options.limits.header_limit));
+    parser_->body_limit(ctx->options.limits.body_limit);
 
-    // Set the timeout.
-    //stream_.expires_after(std::chrono::seconds(30));
+    // Set the timeout, so idle keep-alive connections get closed.
+    // While responses are written, the deadline of the writes stays in effect.
+    if (queue_.is_empty())
+    {
+      stream_.expires_after(ctx->options.limits.http_idle_timeout);
+    }
 
     // Read a request using the parser-oriented interface
     boost::beast::http::async_read(
@@ -164,6 +192,13 @@ private:
     if (ec == boost::beast::http::error::end_of_stream)
       return do_close();
 
+    // This means the connection was idle for too long
+    if (ec == boost::beast::error::timeout)
+    {
+      SPDLOG_DEBUG("closing idle http session");
+      return do_close();
+    }
+
     if (ec)
     {
       SPDLOG_ERROR("{}", ec.message());
@@ -175,22 +210,33 @@ private:
     {
       // Create a websocket session, transferring ownership
       // of both the socket and the HTTP request.
+      // The websocket manages its own timeouts.
+      stream_.expires_never();
       auto ws = std::make_shared<websocket_session>(
           context_,
           stream_.release_socket());
+      // the session registers itself with the context once the handshake completed
       ws->do_accept(parser_->release());
 
-      auto ctx = context_.lock();
-      if (ctx)
-      {
-        ctx->add_ws_session(ws);
-      }
-
       return;
     }
 
-    // Send the response
-    handle_request(*doc_root_, parser_->release(), queue_);
+    // Send the response, blobs are served from memory
+    boost::beast::string_view target = parser_->get().target();
+    if (target.starts_with("/audience/blob/"))
+    {
+      auto ctx = context_.lock();
+      auto id = std::string(target.substr(target.rfind('/') + 1));
+      id = id.substr(0, id.find('?'));
+      // large blobs may take longer than the idle timeout to be consumed,
+      // it is armed again once all responses have been written
+      stream_.expires_never();
+      handle_blob_request(ctx ? ctx->get_blob(id) : nullptr, parser_->release(), queue_);
+    }
+    else
+    {
+      handle_request(*doc_root_, parser_->release(), queue_);
+    }
 
     // If we aren't at the queue limit, try to pipeline another request
     if (!queue_.is_full())
@@ -221,6 +267,15 @@ private:
       // Read another request
       do_read();
     }
+    else if (queue_.is_empty())
+    {
+      // A read is pending already, consider the connection idle from now on
+      auto ctx = context_.lock();
+      if (ctx)
+      {
+        stream_.expires_after(ctx->options.limits.http_idle_timeout);
+      }
+    }
   }
 
   void
@@ -72,6 +72,13 @@ public:
   }
 
 private:
+  bool
+  accept_connection()
+  {
+    auto ctx = context_.lock();
+    return ctx && ctx->connections < ctx->options.limits.max_connections;
+  }
+
   void
   do_accept()
   {
@@ -90,6 +97,12 @@ private:
     {
       SPDLOG_ERROR("{}", ec.message());
     }
+    else if (!accept_connection())
+    {
+      SPDLOG_WARN("connection limit reached, rejecting connection");
+      boost::beast::error_code ignored;
+      socket.close(ignored);
+    }
     else
     {
       // Create the http session and run it
@@ -6,10 +6,37 @@
 #include "process.h"
 #include "context.h"
 
-WebserverContext webserver_start(std::string address, unsigned short &port, std::string doc_root, int threads, std::function<void(WebserverContext, const std::wstring&)> on_message_handler)
+static void webserver_schedule_reap(WebserverContextWeak weak_context)
 {
-  auto context = std::make_shared<WebserverContextData>(threads);
+  auto context = weak_context.lock();
+  if (!context)
+  {
+    return;
+  }
+
+  // drop expired sessions and subscriptions periodically instead of waiting for the next broadcast
+  context->reaper.expires_after(context->options.limits.reap_interval);
+  context->reaper.async_wait([weak_context](boost::beast::error_code ec) {
+    if (ec)
+    {
+      return;
+    }
+    auto context = weak_context.lock();
+    if (context)
+    {
+      context->reap();
+      SPDLOG_TRACE("{} open connections", context->connections.load());
+    }
+    webserver_schedule_reap(weak_context);
+  });
+}
+
+WebserverContext webserver_start(std::string address, unsigned short &port, std::string doc_root, int threads, const WebserverOptions &options, std::function<void(WebserverContext, std::string_view)> on_message_handler, std::function<void(WebserverContext, std::string_view)> on_binary_handler, std::function<void(WebserverContext)> on_resync_handler)
+{
+  auto context = std::make_shared<WebserverContextData>(threads, options);
   context->on_message_handler = on_message_handler;
+  context->on_binary_handler = on_binary_handler;
+  context->on_resync_handler = on_resync_handler;
 
   // Create and launch a listening port
   auto l = std::make_shared<listener>(
@@ -22,6 +49,7 @@ WebserverContext webserver_start(std::string address, unsigned short &port, std:
   SPDLOG_INFO("webserver started at {}:{}", address, port);
 
   l->run();
+  webserver_schedule_reap(context);
 
   // Run the I/O service on the requested number of threads
   for (auto i = 0; i < threads; ++i)
@@ -35,17 +63,167 @@ WebserverContext webserver_start(std::string address, unsigned short &port, std:
   return context;
 }
 
-void webserver_post_message(WebserverContext context, const std::wstring& message)
+static void webserver_post_sequenced(WebserverContext context, bool binary, std::shared_ptr<const std::string> body)
 {
+  // sequence, remember and deliver atomically with respect to resuming sessions
+  auto &replay = context->replay;
+  std::lock_guard<std::mutex> lock(replay.mutex);
+
+  replay.ring.push_back({replay.next_seq++, binary, body});
+  replay.ring_bytes += body->size();
+  while (!replay.ring.empty() && (replay.ring.size() > context->options.replay.capacity || replay.ring_bytes > context->options.replay.max_bytes))
+  {
+    replay.ring_bytes -= replay.ring.front().data->size();
+    replay.ring.pop_front();
+  }
+
   auto sessions = context->get_ws_sessions();
   SPDLOG_DEBUG("found {} valid sessions", sessions.size());
 
   for (auto &session : sessions)
   {
-    session->queue_write(message);
+    if (binary)
+    {
+      session->queue_write_binary(body);
+    }
+    else
+    {
+      session->queue_write(body);
+    }
   }
 }
 
+void webserver_post_message(WebserverContext context, std::string_view message)
+{
+  // one buffer shared by all sessions
+  webserver_post_sequenced(context, false, std::make_shared<const std::string>(message));
+}
+
+void webserver_post_binary(WebserverContext context, const void *data, std::size_t length)
+{
+  webserver_post_sequenced(context, true, std::make_shared<const std::string>(static_cast<const char *>(data), length));
+}
+
+void webserver_state_set(WebserverContext context, const std::string &path, const std::string &value)
+{
+  auto parsed = nlohmann::json::parse(value);
+  nlohmann::json::json_pointer pointer(path);
+
+  std::lock_guard<std::mutex> lock(context->state.mutex);
+  context->state.current[pointer] = std::move(parsed);
+}
+
+void webserver_state_remove(WebserverContext context, const std::string &path)
+{
+  nlohmann::json::json_pointer pointer(path);
+
+  std::lock_guard<std::mutex> lock(context->state.mutex);
+  if (pointer.empty())
+  {
+    context->state.current = nlohmann::json::object();
+    return;
+  }
+
+  auto &parent = context->state.current.at(pointer.parent_pointer());
+  if (parent.is_object())
+  {
+    parent.erase(pointer.back());
+  }
+  else if (parent.is_array())
+  {
+    parent.erase(std::stoul(pointer.back()));
+  }
+}
+
+void webserver_state_flush(WebserverContext context)
+{
+  std::lock_guard<std::mutex> lock(context->state.mutex);
+  if (context->state.current == context->state.shipped)
+  {
+    return;
+  }
+
+  // ship changes since last flush as a single patch
+  auto patch = nlohmann::json::diff(context->state.shipped, context->state.current);
+  context->state.shipped = context->state.current;
+  context->state.version += 1;
+
+  auto sessions = context->get_ws_sessions();
+  SPDLOG_DEBUG("shipping state version {} with {} operations to {} sessions", context->state.version, patch.size(), sessions.size());
+
+  auto body = std::make_shared<const std::string>(
+      nlohmann::json{{"type", "state_patch"}, {"version", context->state.version}, {"patch", std::move(patch)}}.dump());
+  for (auto &session : sessions)
+  {
+    session->queue_write_control(body);
+  }
+}
+
+void webserver_publish(const std::vector<WebserverContext> &contexts, const std::string &topic, std::string_view message)
+{
+  // encode once for all subscribers of all windows
+  std::shared_ptr<const std::string> body;
+  std::size_t count = 0;
+
+  for (auto &context : contexts)
+  {
+    for (auto &session : context->get_subscribers(topic))
+    {
+      if (!body)
+      {
+        body = std::make_shared<const std::string>(
+            nlohmann::json{{"type", "publish"}, {"topic", topic}, {"message", std::string(message)}}.dump());
+      }
+      session->queue_write_control(body);
+      count += 1;
+    }
+  }
+
+  SPDLOG_DEBUG("published message on topic {} to {} sessions", topic, count);
+}
+
+static const std::string webserver_blob_prefix = "/audience/blob/";
+
+std::string webserver_blob_publish(WebserverContext context, std::shared_ptr<const WebserverBlob> blob)
+{
+  std::lock_guard<std::mutex> lock(context->blobs.mutex);
+
+  // unguessable 128-bit ids, so blobs of one window cannot be probed by another or by local processes
+  std::string id;
+  do
+  {
+    auto &random = context->blobs.random;
+    uint32_t words[4] = {random(), random(), random(), random()};
+    id = fmt::format("{:08x}{:08x}{:08x}{:08x}", words[0], words[1], words[2], words[3]);
+  } while (context->blobs.entries.count(id) > 0);
+
+  SPDLOG_DEBUG("publishing blob {} of {} bytes", id, blob->length);
+  context->blobs.entries.emplace(id, std::move(blob));
+  return webserver_blob_prefix + id;
+}
+
+void webserver_blob_revoke(WebserverContext context, const std::string &url)
+{
+  // accept full urls and bare ids
+  auto pos = url.rfind('/');
+  auto id = pos == std::string::npos ? url : url.substr(pos + 1);
+
+  // release outside the lock, responses in flight keep the blob alive until they completed
+  std::shared_ptr<const WebserverBlob> blob;
+  {
+    std::lock_guard<std::mutex> lock(context->blobs.mutex);
+    auto i = context->blobs.entries.find(id);
+    if (i == context->blobs.entries.end())
+    {
+      SPDLOG_WARN("blob {} not found", id);
+      return;
+    }
+    blob = std::move(i->second);
+    context->blobs.entries.erase(i);
+  }
+  SPDLOG_DEBUG("revoked blob {}", id);
+}
+
 void webserver_stop(WebserverContext context)
 {
   context->ioc.stop();
@@ -56,6 +234,23 @@ void webserver_stop(WebserverContext context)
     thread.join();
   }
 
+  // release remaining blobs
+  {
+    std::lock_guard<std::mutex> lock(context->blobs.mutex);
+    context->blobs.entries.clear();
+  }
+
+  // report transport statistics
+  auto &statistics = context->statistics;
+  if (statistics.frames > 0)
+  {
+    SPDLOG_INFO("webserver sent {} frames ({} user messages): {} payload bytes, {} wire bytes (ratio {:.3f}), {} us write time",
+                statistics.frames.load(), statistics.messages.load(),
+                statistics.payload_bytes.load(), statistics.wire_bytes.load(),
+                (double)statistics.wire_bytes.load() / (double)std::max<uint64_t>(statistics.payload_bytes.load(), 1),
+                statistics.write_time_us.load());
+  }
+
   context.reset();
 
   SPDLOG_INFO("webserver stopped");
@@ -1,11 +1,68 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <memory>
+#include <functional>
+#include <vector>
+#include <chrono>
 
 struct WebserverContextData;
 typedef std::shared_ptr<WebserverContextData> WebserverContext;
 
-WebserverContext webserver_start(std::string address, unsigned short &port, std::string doc_root, int threads, std::function<void(WebserverContext, const std::wstring &)> on_message_handler);
-void webserver_post_message(WebserverContext context, const std::wstring &message);
+struct WebserverOptions
+{
+  struct
+  {
+    bool enabled = false;
+    int window_bits = 15;
+    int mem_level = 4;
+  } compression;
+  // messages larger than this are written in fragments
+  std::size_t fragment_size = 64 * 1024;
+  // recently posted messages kept for resuming sessions, bounded by count and size
+  struct
+  {
+    std::size_t capacity = 1024;
+    std::size_t max_bytes = 16 * 1024 * 1024;
+  } replay;
+  // resource limits per window, keep long running shells flat in memory
+  struct
+  {
+    std::chrono::seconds http_idle_timeout{30};
+    std::chrono::seconds websocket_idle_timeout{300};
+    std::size_t header_limit = 16 * 1024;
+    std::size_t body_limit = 64 * 1024;
+    std::size_t message_limit = 64 * 1024 * 1024;
+    std::size_t max_connections = 32;
+    std::chrono::seconds reap_interval{30};
+  } limits;
+};
+
+// memory served under /audience/blob/<id>, released as soon as it is revoked and no response refers to it anymore
+struct WebserverBlob
+{
+  const void *data;
+  std::size_t length;
+  std::string mime_type;
+  std::function<void()> release;
+
+  ~WebserverBlob()
+  {
+    if (release)
+    {
+      release();
+    }
+  }
+};
+
+WebserverContext webserver_start(std::string address, unsigned short &port, std::string doc_root, int threads, const WebserverOptions &options, std::function<void(WebserverContext, std::string_view)> on_message_handler, std::function<void(WebserverContext, std::string_view)> on_binary_handler, std::function<void(WebserverContext)> on_resync_handler);
+void webserver_post_message(WebserverContext context, std::string_view message);
+void webserver_post_binary(WebserverContext context, const void *data, std::size_t length);
+void webserver_state_set(WebserverContext context, const std::string &path, const std::string &value);
+void webserver_state_remove(WebserverContext context, const std::string &path);
+void webserver_state_flush(WebserverContext context);
+void webserver_publish(const std::vector<WebserverContext> &contexts, const std::string &topic, std::string_view message);
+std::string webserver_blob_publish(WebserverContext context, std::shared_ptr<const WebserverBlob> blob);
+void webserver_blob_revoke(WebserverContext context, const std::string &url);
 void webserver_stop(WebserverContext context);
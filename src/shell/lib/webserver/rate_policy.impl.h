@@ -0,0 +1,57 @@
+#pragma once
+
+#include <boost/beast/core/rate_policy.hpp>
+#include <limits>
+
+// Unlimited rate policy, which counts the bytes transferred on the wire
+class metered_rate_policy
+{
+  friend class boost::beast::rate_policy_access;
+
+  static std::size_t constexpr all = (std::numeric_limits<std::size_t>::max)();
+
+  std::size_t read_bytes_ = 0;
+  std::size_t written_bytes_ = 0;
+
+  std::size_t
+  available_read_bytes() const noexcept
+  {
+    return all;
+  }
+
+  std::size_t
+  available_write_bytes() const noexcept
+  {
+    return all;
+  }
+
+  void
+  transfer_read_bytes(std::size_t n) noexcept
+  {
+    read_bytes_ += n;
+  }
+
+  void
+  transfer_write_bytes(std::size_t n) noexcept
+  {
+    written_bytes_ += n;
+  }
+
+  void
+  on_timer() const noexcept
+  {
+  }
+
+public:
+  std::size_t
+  read_bytes() const noexcept
+  {
+    return read_bytes_;
+  }
+
+  std::size_t
+  written_bytes() const noexcept
+  {
+    return written_bytes_;
+  }
+};
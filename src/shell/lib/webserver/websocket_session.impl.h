@@ -4,36 +4,86 @@
 #include <boost/beast/http.hpp>
 #include <boost/beast/websocket.hpp>
 #include <memory>
+#include <array>
+#include <map>
+#include <string_view>
 #include <queue>
+#include <chrono>
+#include <algorithm>
 #include <spdlog/spdlog.h>
 
-#include "../../../common/utf.h"
+#include "rate_policy.impl.h"
+#include "write_queue.impl.h"
 #include "context.h"
 
-// Echoes back all received WebSocket messages
+// read buffers grown beyond this size are shrunk after the message got dispatched
+static constexpr std::size_t websocket_read_buffer_retain = 1024 * 1024;
+
+// Extracts a query parameter from a request target
+static inline std::string websocket_query_parameter(std::string_view target, std::string_view name)
+{
+  auto query = target.find('?');
+  while (query != std::string_view::npos)
+  {
+    auto begin = query + 1;
+    auto end = target.find('&', begin);
+    auto pair = target.substr(begin, end == std::string_view::npos ? std::string_view::npos : end - begin);
+    if (pair.size() > name.size() && pair.substr(0, name.size()) == name && pair[name.size()] == '=')
+    {
+      return std::string(pair.substr(name.size() + 1));
+    }
+    query = end;
+  }
+  return std::string();
+}
+
+// Exchanges messages between web app and shell
 class websocket_session : public std::enable_shared_from_this<websocket_session>
 {
+  typedef boost::beast::basic_stream<boost::asio::ip::tcp, boost::beast::tcp_stream::executor_type, metered_rate_policy> metered_stream;
+
   WebserverContextWeak context_;
-  boost::beast::websocket::stream<boost::beast::tcp_stream> ws_;
+  boost::beast::websocket::stream<metered_stream> ws_;
   boost::beast::flat_buffer read_buffer_;
 
-  std::queue<std::wstring> write_queue_;
+  // control messages first and in order, then user messages with large ones interleaved in fragments
+  websocket_write_queue write_queue_;
   bool pending_write_;
-  std::string pending_write_data_;
+  websocket_write_queue::frame pending_write_data_;
+  std::size_t pending_write_wire_bytes_;
+  std::chrono::steady_clock::time_point pending_write_start_;
   std::mutex write_mutex_;
 
+  // incoming fragments by message id
+  std::map<uint32_t, std::string> read_fragments_;
+
+  // position the web app asks to resume from, if any
+  std::string resume_epoch_;
+  uint64_t resume_seq_;
+
+
 public:
   // Take ownership of the socket
   explicit websocket_session(
       WebserverContextWeak context,
       boost::asio::ip::tcp::socket &&socket)
-      : context_(context), ws_(std::move(socket)), pending_write_(false)
+      : context_(context), ws_(std::move(socket)), write_queue_(WebserverOptions{}.fragment_size), pending_write_(false), pending_write_wire_bytes_(0), resume_seq_(0)
   {
+    auto ctx = context_.lock();
+    if (ctx)
+    {
+      ctx->connections += 1;
+    }
     SPDLOG_INFO("websocket session created");
   }
 
   ~websocket_session()
   {
+    auto ctx = context_.lock();
+    if (ctx)
+    {
+      ctx->connections -= 1;
+    }
     SPDLOG_INFO("websocket session closed");
   }
 
@@ -42,10 +92,30 @@ public:
   void
   do_accept(boost::beast::http::request<Body, boost::beast::http::basic_fields<Allocator>> req)
   {
-    // Set suggested timeout settings for the websocket
-    ws_.set_option(
-        boost::beast::websocket::stream_base::timeout::suggested(
-            boost::beast::role_type::server));
+    // Remember resume position, e.g. /?epoch=123&seq=42
+    std::string_view target(req.target().data(), req.target().size());
+    resume_epoch_ = websocket_query_parameter(target, "epoch");
+    try
+    {
+      resume_seq_ = std::stoull(websocket_query_parameter(target, "seq"));
+    }
+    catch (...)
+    {
+      resume_epoch_.clear();
+    }
+
+    // Set suggested timeout settings for the websocket, but drop idle
+    // peers which do not answer our pings anymore
+    auto ctx = context_.lock();
+    auto timeout = boost::beast::websocket::stream_base::timeout::suggested(
+        boost::beast::role_type::server);
+    if (ctx)
+    {
+      timeout.idle_timeout = ctx->options.limits.websocket_idle_timeout;
+      timeout.keep_alive_pings = true;
+      ws_.read_message_max(ctx->options.limits.message_limit);
+    }
+    ws_.set_option(timeout);
 
     // Set a decorator to change the Server of the handshake
     ws_.set_option(boost::beast::websocket::stream_base::decorator(
@@ -55,6 +125,22 @@ public:
                       " advanced-server");
         }));
 
+    // Offer permessage-deflate, if enabled
+    if (ctx)
+    {
+      write_queue_.fragment_size(ctx->options.fragment_size);
+    }
+    if (ctx && ctx->options.compression.enabled)
+    {
+      boost::beast::websocket::permessage_deflate pmd;
+      pmd.server_enable = true;
+      pmd.server_max_window_bits = std::clamp(ctx->options.compression.window_bits, 9, 15);
+      pmd.client_max_window_bits = pmd.server_max_window_bits;
+      pmd.memLevel = std::clamp(ctx->options.compression.mem_level, 1, 9);
+      ws_.set_option(pmd);
+      SPDLOG_DEBUG("offering permessage-deflate: window_bits={} mem_level={}", pmd.server_max_window_bits, pmd.memLevel);
+    }
+
     // Accept the websocket handshake
     ws_.async_accept(
         req,
@@ -64,16 +150,40 @@ public:
   }
 
   void
-  queue_write(const std::wstring& body)
+  queue_write(std::shared_ptr<const std::string> body)
+  {
+    queue_message(websocket_message{WEBSOCKET_MESSAGE_TEXT, std::move(body)});
+  }
+
+  void
+  queue_write_binary(std::shared_ptr<const std::string> body)
+  {
+    queue_message(websocket_message{WEBSOCKET_MESSAGE_BINARY, std::move(body)});
+  }
+
+  void
+  queue_write_control(std::shared_ptr<const std::string> body)
+  {
+    queue_message(websocket_message{WEBSOCKET_MESSAGE_CONTROL, std::move(body)});
+  }
+
+private:
+  void
+  queue_message(websocket_message &&msg)
   {
     {
       std::lock_guard<std::mutex> lock(write_mutex_);
-      write_queue_.push(body);
+      write_queue_.push(std::move(msg));
     }
-    do_write();
+
+    // writes are initiated on the strand of the session only
+    boost::asio::post(
+        ws_.get_executor(),
+        boost::beast::bind_front_handler(
+            &websocket_session::do_write,
+            shared_from_this()));
   }
 
-private:
   void
   on_accept(boost::beast::error_code ec)
   {
@@ -83,6 +193,56 @@ private:
       return;
     }
 
+    // resume, register session and send state snapshot, atomically with respect to posts and state flushes
+    auto ctx = context_.lock();
+    auto resync = false;
+    if (ctx)
+    {
+      std::lock_guard<std::mutex> state_lock(ctx->state.mutex);
+      std::lock_guard<std::mutex> replay_lock(ctx->replay.mutex);
+      auto &replay = ctx->replay;
+
+      // resume right after the last message seen, if the ring still covers the gap
+      auto start = replay.next_seq;
+      if (!resume_epoch_.empty())
+      {
+        auto first = replay.ring.empty() ? replay.next_seq : replay.ring.front().seq;
+        if (resume_epoch_ == replay.epoch && resume_seq_ < replay.next_seq && resume_seq_ + 1 >= first)
+        {
+          start = resume_seq_ + 1;
+        }
+        else
+        {
+          resync = true;
+        }
+      }
+      SPDLOG_DEBUG("session starts at sequence {}, replaying {} messages{}", start, replay.next_seq - start, resync ? ", resync needed" : "");
+
+      queue_write_control(std::make_shared<const std::string>(
+          nlohmann::json{{"type", "session"}, {"epoch", replay.epoch}, {"seq", start}, {"resync", resync}}.dump()));
+      for (auto &entry : replay.ring)
+      {
+        if (entry.seq >= start)
+        {
+          queue_message(websocket_message{entry.binary ? WEBSOCKET_MESSAGE_BINARY : WEBSOCKET_MESSAGE_TEXT, entry.data});
+        }
+      }
+
+      auto self = shared_from_this();
+      ctx->add_ws_session(self);
+      if (ctx->state.version > 0)
+      {
+        queue_write_control(std::make_shared<const std::string>(
+            nlohmann::json{{"type", "state"}, {"version", ctx->state.version}, {"state", ctx->state.shipped}}.dump()));
+      }
+    }
+
+    // let the backend know its messages got lost, outside of the locks
+    if (resync && ctx->on_resync_handler)
+    {
+      ctx->on_resync_handler(ctx);
+    }
+
     // Read a message
     do_read();
   }
@@ -115,37 +275,207 @@ private:
       return;
     }
 
-    // pass to handler
-    auto ctx = context_.lock();
-    if (ctx && ctx->on_message_handler)
+    // pass to handler, the flat buffer is contiguous and stays valid until consumed
+    auto data = read_buffer_.data();
+    std::string_view view(static_cast<const char *>(data.data()), data.size());
+    if (!ws_.got_binary())
+    {
+      dispatch_message(false, view);
+    }
+    else if (view.size() >= 1 && view[0] == WEBSOCKET_FRAME_BINARY)
     {
-      ctx->on_message_handler(ctx, utf8_to_utf16(boost::beast::buffers_to_string(read_buffer_.data())));
+      dispatch_message(true, view.substr(1));
+    }
+    else if (view.size() >= 1 && view[0] == WEBSOCKET_FRAME_CONTROL)
+    {
+      on_control(view.substr(1));
+    }
+    else if (view.size() >= websocket_fragment_header_size && view[0] == WEBSOCKET_FRAME_FRAGMENT)
+    {
+      if (!on_read_fragment(view))
+      {
+        return do_close(boost::beast::websocket::close_code::too_big);
+      }
+    }
+    else
+    {
+      SPDLOG_ERROR("received malformed binary frame");
     }
 
-    // Clear the buffer
+    // Clear the buffer and give back memory of large messages
     read_buffer_.consume(read_buffer_.size());
+    if (read_buffer_.capacity() > websocket_read_buffer_retain)
+    {
+      read_buffer_.shrink_to_fit();
+    }
 
     // Do another read
     do_read();
   }
 
+  void
+  do_close(boost::beast::websocket::close_code code)
+  {
+    ws_.async_close(
+        code,
+        boost::beast::bind_front_handler(
+            &websocket_session::on_close,
+            shared_from_this()));
+  }
+
+  void
+  on_close(boost::beast::error_code ec)
+  {
+    if (ec)
+    {
+      SPDLOG_ERROR("{}", ec.message());
+    }
+  }
+
+  bool
+  on_read_fragment(std::string_view frame)
+  {
+    auto flags = static_cast<uint8_t>(frame[1]);
+    uint32_t id = 0;
+    for (auto i = 0; i < 4; ++i)
+    {
+      id |= static_cast<uint32_t>(static_cast<uint8_t>(frame[2 + i])) << (8 * i);
+    }
+
+    // reassembled messages are subject to the same limit as whole ones
+    auto payload = frame.substr(websocket_fragment_header_size);
+    std::size_t pending = payload.size();
+    for (auto &i : read_fragments_)
+    {
+      pending += i.second.size();
+    }
+    if (pending > ws_.read_message_max())
+    {
+      SPDLOG_ERROR("fragmented messages exceed limit of {} bytes", ws_.read_message_max());
+      read_fragments_.clear();
+      return false;
+    }
+
+    auto &buffer = read_fragments_[id];
+    buffer.append(payload);
+
+    if (flags & WEBSOCKET_FRAGMENT_LAST)
+    {
+      SPDLOG_DEBUG("reassembled fragmented message of {} bytes", buffer.size());
+      auto message = std::move(buffer);
+      read_fragments_.erase(id);
+      if (flags & WEBSOCKET_FRAGMENT_CONTROL)
+      {
+        on_control(message);
+      }
+      else
+      {
+        dispatch_message(flags & WEBSOCKET_FRAGMENT_BINARY, message);
+      }
+    }
+    return true;
+  }
+
+  void
+  on_control(std::string_view data)
+  {
+    auto ctx = context_.lock();
+    if (!ctx)
+    {
+      return;
+    }
+
+    // the web app is not trusted, malformed messages must not reach the io thread as exceptions
+    auto control = nlohmann::json::parse(data, nullptr, false);
+    if (!control.is_object() || !control.contains("type") || !control["type"].is_string())
+    {
+      SPDLOG_ERROR("received malformed control message");
+      return;
+    }
+
+    try
+    {
+      auto type = control["type"].get<std::string>();
+      if (type == "subscribe" || type == "unsubscribe")
+      {
+        if (!control.contains("topic") || !control["topic"].is_string())
+        {
+          SPDLOG_ERROR("received {} control message without topic", type);
+          return;
+        }
+        auto topic = control["topic"].get<std::string>();
+        SPDLOG_DEBUG("session {} topic {}", type == "subscribe" ? "subscribed to" : "unsubscribed from", topic);
+        if (type == "subscribe")
+        {
+          ctx->subscribe(topic, shared_from_this());
+        }
+        else
+        {
+          ctx->unsubscribe(topic, shared_from_this());
+        }
+      }
+      else if (type == "state_sync")
+      {
+        // web app missed a state version, ship a fresh snapshot behind the patches queued so far
+        std::lock_guard<std::mutex> state_lock(ctx->state.mutex);
+        SPDLOG_DEBUG("session requested state snapshot of version {}", ctx->state.version);
+        queue_write_control(std::make_shared<const std::string>(
+            nlohmann::json{{"type", "state"}, {"version", ctx->state.version}, {"state", ctx->state.shipped}}.dump()));
+      }
+      else
+      {
+        SPDLOG_WARN("received unknown control message {}", type);
+      }
+    }
+    catch (const nlohmann::json::exception &e)
+    {
+      SPDLOG_ERROR("could not handle control message: {}", e.what());
+    }
+  }
+
+  void
+  dispatch_message(bool binary, std::string_view data)
+  {
+    auto ctx = context_.lock();
+    if (!ctx)
+    {
+      return;
+    }
+
+    if (binary && ctx->on_binary_handler)
+    {
+      ctx->on_binary_handler(ctx, data);
+    }
+    else if (!binary && ctx->on_message_handler)
+    {
+      ctx->on_message_handler(ctx, data);
+    }
+  }
+
   void
   do_write()
   {
     std::lock_guard<std::mutex> lock(write_mutex_);
-    if (pending_write_ == false && write_queue_.size() > 0)
+    if (pending_write_ == false && !write_queue_.empty())
     {
       SPDLOG_DEBUG("writing message to websocket");
 
-      // pop and buffer data
+      // pop whole message or next fragment
       pending_write_ = true;
-      pending_write_data_ = utf16_to_utf8(write_queue_.front());
-      write_queue_.pop();
+      pending_write_data_ = write_queue_.pop();
+
+      // remember state for statistics
+      pending_write_wire_bytes_ = boost::beast::get_lowest_layer(ws_).rate_policy().written_bytes();
+      pending_write_start_ = std::chrono::steady_clock::now();
 
       // trigger write
-      ws_.text(true);
+      auto &frame = pending_write_data_;
+      std::array<boost::asio::const_buffer, 2> buffers{
+          boost::asio::buffer(frame.header.data(), frame.header_size),
+          boost::asio::buffer(frame.message.data->data() + frame.payload_offset, frame.payload_size)};
+      ws_.binary(frame.header_size > 0);
       ws_.async_write(
-          boost::asio::buffer(pending_write_data_),
+          buffers,
           boost::beast::bind_front_handler(
               &websocket_session::on_write,
               shared_from_this()));
@@ -157,13 +487,18 @@ private:
       boost::beast::error_code ec,
       std::size_t bytes_transferred)
   {
-    boost::ignore_unused(bytes_transferred);
     SPDLOG_DEBUG("write operation completed");
 
-    // unset pending write flag
+    // unset pending write flag and requeue remaining fragments behind waiting messages
+    bool message_written = false;
     {
       std::lock_guard<std::mutex> lock(write_mutex_);
       pending_write_ = false;
+      if (!ec)
+      {
+        message_written = pending_write_data_.last() && pending_write_data_.message.type != WEBSOCKET_MESSAGE_CONTROL;
+        write_queue_.requeue(std::move(pending_write_data_));
+      }
     }
 
     if (ec)
@@ -172,7 +507,30 @@ private:
       return;
     }
 
+    // collect statistics
+    auto wire_bytes = boost::beast::get_lowest_layer(ws_).rate_policy().written_bytes() - pending_write_wire_bytes_;
+    auto write_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - pending_write_start_);
+    record_write(message_written, bytes_transferred, wire_bytes, write_time);
+
     // write next
     do_write();
   }
+
+  void
+  record_write(bool message_written, std::size_t payload_bytes, std::size_t wire_bytes, std::chrono::microseconds write_time)
+  {
+    auto ctx = context_.lock();
+    if (!ctx)
+    {
+      return;
+    }
+
+    // write time is the wall time of the async write, including deflate and waiting for the peer
+    ctx->statistics.frames += 1;
+    ctx->statistics.messages += message_written ? 1 : 0;
+    ctx->statistics.payload_bytes += payload_bytes;
+    ctx->statistics.wire_bytes += wire_bytes;
+    ctx->statistics.write_time_us += write_time.count();
+    SPDLOG_TRACE("frame written: {} payload bytes, {} wire bytes in {} us", payload_bytes, wire_bytes, write_time.count());
+  }
 };
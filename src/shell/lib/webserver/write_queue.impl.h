@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <string>
+#include <algorithm>
+
+// Binary frames start with a kind byte, text frames carry plain messages:
+// - binary: user binary message follows
+// - fragment: flags byte and message id (uint32, little endian) follow, then a slice of the message
+// - control: json encoded control message of the shell follows (e.g. state synchronization)
+enum websocket_frame_kind : uint8_t
+{
+  WEBSOCKET_FRAME_BINARY = 0,
+  WEBSOCKET_FRAME_FRAGMENT = 1,
+  WEBSOCKET_FRAME_CONTROL = 2
+};
+
+enum websocket_fragment_flags : uint8_t
+{
+  WEBSOCKET_FRAGMENT_BINARY = 1,
+  WEBSOCKET_FRAGMENT_LAST = 2,
+  WEBSOCKET_FRAGMENT_CONTROL = 4
+};
+
+static constexpr std::size_t websocket_fragment_header_size = 6;
+
+enum websocket_message_type
+{
+  WEBSOCKET_MESSAGE_TEXT,
+  WEBSOCKET_MESSAGE_BINARY,
+  WEBSOCKET_MESSAGE_CONTROL
+};
+
+struct websocket_message
+{
+  websocket_message_type type = WEBSOCKET_MESSAGE_TEXT;
+  std::shared_ptr<const std::string> data;
+  std::size_t offset = 0;
+  uint32_t fragment_id = 0;
+};
+
+// Orders outgoing messages of a session and cuts them into frames:
+// - control messages (state snapshots and patches, publications) are written whole and
+//   in order, ahead of user messages, so they never overtake each other
+// - large user messages are written in fragments, which are interleaved round robin with
+//   other user messages
+// - not thread safe, the session guards it by its write mutex
+class websocket_write_queue
+{
+  std::queue<websocket_message> control_;
+  std::queue<websocket_message> data_;
+  std::size_t fragment_size_;
+  uint32_t next_fragment_id_;
+
+public:
+  struct frame
+  {
+    websocket_message message;
+    std::array<uint8_t, websocket_fragment_header_size> header{};
+    std::size_t header_size = 0;
+    std::size_t payload_offset = 0;
+    std::size_t payload_size = 0;
+
+    // whole message has been framed
+    bool last() const
+    {
+      return !message.data || message.offset >= message.data->size();
+    }
+  };
+
+  explicit websocket_write_queue(std::size_t fragment_size) : fragment_size_(std::max<std::size_t>(fragment_size, 1)), next_fragment_id_(0) {}
+
+  void fragment_size(std::size_t size)
+  {
+    fragment_size_ = std::max<std::size_t>(size, 1);
+  }
+
+  void push(websocket_message &&msg)
+  {
+    (msg.type == WEBSOCKET_MESSAGE_CONTROL ? control_ : data_).push(std::move(msg));
+  }
+
+  bool empty() const
+  {
+    return control_.empty() && data_.empty();
+  }
+
+  // takes the next frame to write, the queue must not be empty
+  frame pop()
+  {
+    frame next;
+    auto &source = control_.empty() ? data_ : control_;
+    next.message = std::move(source.front());
+    source.pop();
+
+    auto &msg = next.message;
+    if (msg.type == WEBSOCKET_MESSAGE_CONTROL || (msg.offset == 0 && msg.data->size() <= fragment_size_))
+    {
+      if (msg.type == WEBSOCKET_MESSAGE_BINARY)
+      {
+        next.header[next.header_size++] = WEBSOCKET_FRAME_BINARY;
+      }
+      else if (msg.type == WEBSOCKET_MESSAGE_CONTROL)
+      {
+        next.header[next.header_size++] = WEBSOCKET_FRAME_CONTROL;
+      }
+      next.payload_offset = 0;
+      next.payload_size = msg.data->size();
+      msg.offset = msg.data->size();
+    }
+    else
+    {
+      if (msg.offset == 0)
+      {
+        msg.fragment_id = next_fragment_id_++;
+      }
+      auto length = std::min(fragment_size_, msg.data->size() - msg.offset);
+      auto last = msg.offset + length == msg.data->size();
+      next.header[next.header_size++] = WEBSOCKET_FRAME_FRAGMENT;
+      next.header[next.header_size++] = (msg.type == WEBSOCKET_MESSAGE_BINARY ? WEBSOCKET_FRAGMENT_BINARY : 0) | (last ? WEBSOCKET_FRAGMENT_LAST : 0);
+      for (auto i = 0; i < 4; ++i)
+      {
+        next.header[next.header_size++] = static_cast<uint8_t>(msg.fragment_id >> (8 * i));
+      }
+      next.payload_offset = msg.offset;
+      next.payload_size = length;
+      msg.offset += length;
+    }
+    return next;
+  }
+
+  // puts the rest of a partly written message behind waiting user messages
+  void requeue(frame &&written)
+  {
+    if (!written.last())
+    {
+      data_.push(std::move(written.message));
+    }
+  }
+};
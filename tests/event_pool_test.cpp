@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "shell/lib/event_pool.h"
+#include "test.h"
+
+// waits until condition holds, fails after a generous timeout instead of hanging
+template <typename Condition>
+static bool eventually(Condition condition)
+{
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!condition())
+  {
+    if (std::chrono::steady_clock::now() > deadline)
+    {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+TEST(tasks_of_a_window_run_in_order)
+{
+  ShellEventPool pool;
+  pool.start(4, 1000);
+
+  std::mutex mutex;
+  std::map<AudienceWindowHandle, std::vector<int>> seen;
+  for (auto i = 0; i < 1000; ++i)
+  {
+    AudienceWindowHandle handle = i % 4 + 1;
+    CHECK(pool.post(
+        handle, [&, handle, i] {
+          std::lock_guard<std::mutex> lock(mutex);
+          seen[handle].push_back(i);
+        },
+        true));
+  }
+
+  CHECK(eventually([&] {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t count = 0;
+    for (auto &i : seen)
+    {
+      count += i.second.size();
+    }
+    return count == 1000;
+  }));
+  for (auto &i : seen)
+  {
+    CHECK(std::is_sorted(i.second.begin(), i.second.end()));
+  }
+  pool.stop();
+}
+
+TEST(full_queue_rejects_or_blocks)
+{
+  ShellEventPool pool;
+  pool.start(1, 2);
+
+  // keep the only worker busy with the first task
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  std::atomic<bool> started{false};
+  std::atomic<int> ran{0};
+  CHECK(pool.post(
+      1, [&] { started = true; released.wait(); ran += 1; }, false));
+  CHECK(eventually([&] { return started.load(); }));
+  CHECK(pool.post(1, [&] { ran += 1; }, false));
+  CHECK(pool.post(1, [&] { ran += 1; }, false));
+  CHECK(!pool.post(1, [&] { ran += 1; }, false));
+
+  // other windows have their own queue
+  CHECK(pool.post(2, [&] { ran += 1; }, false));
+
+  // a waiting poster gets through once the worker makes progress
+  auto waiting = std::async(std::launch::async, [&] { return pool.post(1, [&] { ran += 1; }, true); });
+  CHECK(waiting.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout);
+  release.set_value();
+  CHECK(waiting.get());
+  CHECK(eventually([&] { return ran == 5; }));
+  pool.stop();
+}
+
+TEST(close_drops_pending_and_wakes_waiters)
+{
+  ShellEventPool pool;
+  pool.start(1, 1);
+
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  std::atomic<bool> started{false};
+  std::atomic<int> ran{0};
+  CHECK(pool.post(
+      1, [&] { started = true; released.wait(); ran += 1; }, false));
+  CHECK(eventually([&] { return started.load(); }));
+  CHECK(pool.post(1, [&] { ran += 100; }, false));
+
+  // a transport thread blocks on the full queue, closing the window must release it
+  auto waiting = std::async(std::launch::async, [&] { return pool.post(1, [&] { ran += 100; }, true); });
+  CHECK(waiting.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout);
+  pool.close(1);
+  CHECK(waiting.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+  CHECK(!waiting.get());
+  CHECK(!pool.post(1, [&] { ran += 100; }, false));
+
+  // the running task completes, pending ones of the closed window never run
+  release.set_value();
+  CHECK(eventually([&] { return ran == 1; }));
+  CHECK(pool.post(2, [&] { ran += 1; }, false));
+  CHECK(eventually([&] { return ran == 2; }));
+  CHECK(ran == 2);
+
+  // a reopened handle accepts tasks again
+  pool.open(1);
+  CHECK(pool.post(1, [&] { ran += 1; }, false));
+  CHECK(eventually([&] { return ran == 3; }));
+  pool.stop();
+}
+
+TEST(stop_wakes_waiters)
+{
+  ShellEventPool pool;
+  pool.start(1, 1);
+
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  auto started = std::make_shared<std::atomic<bool>>(false);
+  CHECK(pool.post(
+      1, [released, started] { *started = true; released.wait(); }, false));
+  CHECK(eventually([&] { return started->load(); }));
+  CHECK(pool.post(1, [] {}, false));
+  auto waiting = std::async(std::launch::async, [&] { return pool.post(1, [] {}, true); });
+  CHECK(waiting.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout);
+  pool.stop();
+  CHECK(!waiting.get());
+  CHECK(!pool.post(1, [] {}, false));
+  release.set_value();
+}
+
+TEST_MAIN()
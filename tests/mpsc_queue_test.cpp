@@ -0,0 +1,82 @@
+#include <thread>
+#include <vector>
+
+#include "common/mpsc_queue.h"
+#include "test.h"
+
+struct item : mpsc_node
+{
+  int producer;
+  int value;
+};
+
+TEST(single_producer_is_fifo)
+{
+  mpsc_queue queue;
+  CHECK(queue.pop() == nullptr);
+
+  std::vector<item> items(100);
+  for (auto i = 0; i < 100; ++i)
+  {
+    items[i].value = i;
+    queue.push(&items[i]);
+  }
+  for (auto i = 0; i < 100; ++i)
+  {
+    auto node = queue.pop();
+    CHECK(node != nullptr);
+    CHECK(static_cast<item *>(node)->value == i);
+  }
+  CHECK(queue.pop() == nullptr);
+
+  // the queue stays usable once drained, including a single node
+  queue.push(&items[0]);
+  CHECK(queue.pop() == &items[0]);
+  CHECK(queue.pop() == nullptr);
+}
+
+TEST(concurrent_producers_keep_their_order)
+{
+  constexpr int producers = 4;
+  constexpr int count = 100000;
+
+  mpsc_queue queue;
+  std::vector<std::thread> threads;
+  for (auto p = 0; p < producers; ++p)
+  {
+    threads.emplace_back([&queue, p] {
+      for (auto i = 0; i < count; ++i)
+      {
+        auto node = new item;
+        node->producer = p;
+        node->value = i;
+        queue.push(node);
+      }
+    });
+  }
+
+  // tasks of one producer never overtake each other, only producers interleave
+  std::vector<int> last(producers, -1);
+  long received = 0;
+  while (received < long(producers) * count)
+  {
+    auto node = static_cast<item *>(queue.pop());
+    if (node == nullptr)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    CHECK(node->value == last[node->producer] + 1);
+    last[node->producer] = node->value;
+    delete node;
+    received += 1;
+  }
+
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+  CHECK(queue.pop() == nullptr);
+}
+
+TEST_MAIN()
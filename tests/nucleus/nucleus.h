@@ -0,0 +1,12 @@
+#pragma once
+
+#include <memory>
+
+// window context of the nucleus stub used by the tests
+struct AudienceWindowContextData
+{
+  AudienceRect frame;
+  bool has_focus;
+};
+
+using AudienceWindowContext = std::shared_ptr<AudienceWindowContextData>;
@@ -0,0 +1,131 @@
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "nucleus/shared/interface.h"
+#include "test.h"
+
+NUCLEUS_PUBIMPL("test")
+
+// main loop of the nucleus stub, dispatched tasks run when the test drains it
+static std::deque<std::pair<void (*)(void *), void *>> main_queue;
+
+static void run_main_queue()
+{
+  while (!main_queue.empty())
+  {
+    auto task = main_queue.front();
+    main_queue.pop_front();
+    task.first(task.second);
+  }
+}
+
+bool nucleus_impl_init(AudienceNucleusProtocolNegotiation &negotiation, const NucleusImplAppDetails &)
+{
+  negotiation.nucleus_handles_webapp_type_url = true;
+  negotiation.nucleus_publishes_geometry = true;
+  return true;
+}
+
+AudienceScreenList nucleus_impl_screen_list() { return AudienceScreenList{}; }
+
+AudienceWindowContext nucleus_impl_window_create(const NucleusImplWindowDetails &details)
+{
+  return std::make_shared<AudienceWindowContextData>(AudienceWindowContextData{details.position, true});
+}
+
+NucleusImplWindowStatus nucleus_impl_window_status(AudienceWindowContext context)
+{
+  return NucleusImplWindowStatus{context->has_focus, context->frame, AudienceSize{1920, 1080}};
+}
+
+void nucleus_impl_window_update_position(AudienceWindowContext context, AudienceRect position)
+{
+  context->frame = position;
+  emit_windows_changed();
+}
+
+void nucleus_impl_window_post_message(AudienceWindowContext, const std::wstring &) {}
+void nucleus_impl_window_destroy(AudienceWindowContext) {}
+void nucleus_impl_quit() {}
+void nucleus_impl_main() {}
+void nucleus_impl_dispatch_sync(void (*task)(void *context), void *context) { task(context); }
+void nucleus_impl_dispatch_async(void (*task)(void *context), void *context) { main_queue.emplace_back(task, context); }
+void nucleus_impl_dispatch_after(uint32_t, void (*task)(void *context), void *context) { main_queue.emplace_back(task, context); }
+int nucleus_impl_event_fd() { return -1; }
+int nucleus_impl_poll(int) { return 0; }
+void nucleus_impl_window_animate(AudienceWindowContext, AudienceRect, uint32_t, AudienceEasing) {}
+
+// shell stub, events of windows it has no record of get dropped like in the shell
+static std::map<AudienceWindowHandle, bool> shell_records;
+static std::vector<std::pair<AudienceWindowHandle, AudienceRect>> shell_geometry;
+static std::vector<std::pair<AudienceWindowHandle, bool>> shell_focus;
+
+static AudienceNucleusProtocolNegotiation negotiation_with_shell()
+{
+  AudienceNucleusProtocolNegotiation negotiation{};
+  negotiation.shell_event_handler.window_level.on_geometry_change = [](AudienceWindowHandle handle, AudienceRect frame, AudienceSize) {
+    if (shell_records.count(handle) > 0)
+    {
+      shell_geometry.emplace_back(handle, frame);
+    }
+  };
+  negotiation.shell_event_handler.window_level.on_focus_change = [](AudienceWindowHandle handle, bool has_focus) {
+    if (shell_records.count(handle) > 0)
+    {
+      shell_focus.emplace_back(handle, has_focus);
+    }
+  };
+  return negotiation;
+}
+
+static AudienceWindowHandle shell_window_create(AudienceRect position)
+{
+  AudienceWindowDetails details{};
+  details.webapp_type = AUDIENCE_WEBAPP_TYPE_URL;
+  details.webapp_location = L"http://localhost/";
+  details.position = position;
+  auto handle = nucleus_window_create(&details);
+  if (handle != AudienceWindowHandle{})
+  {
+    shell_records[handle] = true;
+  }
+  return handle;
+}
+
+static bool same_rect(AudienceRect a, AudienceRect b)
+{
+  return std::memcmp(&a, &b, sizeof(AudienceRect)) == 0;
+}
+
+TEST(new_window_reports_initial_geometry)
+{
+  static auto negotiation = negotiation_with_shell();
+  AudienceNucleusAppDetails app_details{};
+  CHECK(nucleus_init(&negotiation, &app_details));
+
+  AudienceRect position{{10, 20}, {640, 480}};
+  auto handle = shell_window_create(position);
+  CHECK(handle != AudienceWindowHandle{});
+
+  // the window list is published right away, the report follows once the shell knows the handle
+  auto list = nucleus_window_list();
+  CHECK(list.count == 1 && list.windows[0].handle == handle);
+  CHECK(shell_geometry.empty());
+  run_main_queue();
+  CHECK(shell_geometry.size() == 1);
+  CHECK(shell_geometry[0].first == handle && same_rect(shell_geometry[0].second, position));
+  CHECK(shell_focus.size() == 1);
+  CHECK(shell_focus[0].first == handle && shell_focus[0].second);
+
+  // later changes are reported once, nothing is repeated by the deferred flush
+  AudienceRect moved{{30, 40}, {640, 480}};
+  nucleus_window_update_position(handle, moved);
+  run_main_queue();
+  CHECK(shell_geometry.size() == 2);
+  CHECK(same_rect(shell_geometry[1].second, moved));
+  CHECK(shell_focus.size() == 1);
+}
+
+TEST_MAIN()
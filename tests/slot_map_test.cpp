@@ -0,0 +1,115 @@
+#include <memory>
+#include <set>
+#include <string>
+
+#include "common/slot_map.h"
+#include "test.h"
+
+TEST(handles_resolve_until_erased)
+{
+  slot_map<std::string> map;
+  auto a = map.insert("a");
+  auto b = map.insert("b");
+  CHECK(a != 0 && b != 0 && a != b);
+  CHECK(map.size() == 2);
+  CHECK(*map.find(a) == "a");
+  CHECK(*map.find(b) == "b");
+
+  CHECK(map.erase(a));
+  CHECK(!map.erase(a));
+  CHECK(map.find(a) == nullptr);
+  CHECK(*map.find(b) == "b");
+  CHECK(map.size() == 1);
+  CHECK(map.find(0) == nullptr);
+}
+
+TEST(stale_handles_do_not_resolve_after_reuse)
+{
+  slot_map<int, 2> map; // 4 slots, 16384 generations
+  std::set<uint16_t> seen;
+  auto live = map.insert(0);
+  for (auto i = 1; i < 20000; ++i)
+  {
+    auto handle = map.insert(i);
+    CHECK(handle != 0);
+    CHECK(*map.find(handle) == i);
+    CHECK(map.erase(handle));
+    CHECK(map.find(handle) == nullptr);
+    seen.insert(handle);
+  }
+  CHECK(*map.find(live) == 0);
+
+  // released slots are reused oldest first, so no handle comes back within a single slot's generation cycle
+  CHECK(seen.size() == 19999);
+}
+
+TEST(slots_are_handed_out_before_reuse)
+{
+  slot_map<int, 3> map;
+  auto first = map.insert(1);
+  CHECK(map.erase(first));
+  std::set<uint16_t> indices;
+  for (std::size_t i = 0; i < map.capacity; ++i)
+  {
+    auto handle = map.insert(int(i));
+    CHECK(handle != 0 && handle != first);
+    indices.insert(handle & (map.capacity - 1));
+  }
+  CHECK(indices.size() == map.capacity);
+  CHECK(map.insert(0) == 0);
+}
+
+TEST(adopted_handles_keep_free_list_bounded)
+{
+  slot_map<int> nucleus;
+  slot_map<int> shell;
+  for (auto i = 0; i < 100000; ++i)
+  {
+    auto handle = nucleus.insert(i);
+    CHECK(handle != 0);
+    CHECK(shell.insert_at(handle, i));
+    CHECK(*shell.find(handle) == i);
+    CHECK(shell.erase(handle));
+    CHECK(nucleus.erase(handle));
+  }
+  CHECK(shell.empty());
+
+  // the shell never allocates itself, yet may do so without handing out an adopted slot
+  auto adopted = nucleus.insert(1);
+  CHECK(shell.insert_at(adopted, 1));
+  for (std::size_t i = 1; i < shell.capacity; ++i)
+  {
+    auto handle = shell.insert(int(i));
+    CHECK(handle != 0 && handle != adopted);
+  }
+  CHECK(shell.insert(0) == 0);
+  CHECK(*shell.find(adopted) == 1);
+}
+
+TEST(reverse_index_follows_inserts_and_erases)
+{
+  slot_map<std::shared_ptr<int>, 8, slot_map_identity_key> map;
+  auto a = std::make_shared<int>(1);
+  auto b = std::make_shared<int>(2);
+  auto ha = map.insert(a);
+  auto hb = map.insert(b);
+  CHECK(map.find_handle(a) == ha);
+  CHECK(map.find_handle(b) == hb);
+
+  CHECK(map.erase(ha));
+  CHECK(map.find_handle(a) == 0);
+  CHECK(map.find_handle(b) == hb);
+
+  // null keys are not indexed
+  auto hn = map.insert(nullptr);
+  CHECK(hn != 0);
+  CHECK(map.find_handle(nullptr) == 0);
+
+  // adopting over an occupied slot replaces its index entry
+  auto c = std::make_shared<int>(3);
+  CHECK(map.insert_at(hb, c));
+  CHECK(map.find_handle(b) == 0);
+  CHECK(map.find_handle(c) == hb);
+}
+
+TEST_MAIN()
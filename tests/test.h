@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+// Minimal test harness, checks stay active in release builds (no NDEBUG dependency)
+
+#define CHECK(condition)                                                                 \
+  do                                                                                     \
+  {                                                                                      \
+    if (!(condition))                                                                    \
+    {                                                                                    \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      std::exit(1);                                                                      \
+    }                                                                                    \
+  } while (false)
+
+#define TEST(name)                                        \
+  static void name();                                     \
+  static const bool name##_added = test_add(#name, name); \
+  static void name()
+
+#define TEST_MAIN()                                             \
+  int main()                                                    \
+  {                                                             \
+    for (auto &test : test_registry())                          \
+    {                                                           \
+      std::printf("%s\n", test.first);                          \
+      test.second();                                            \
+    }                                                           \
+    std::printf("%zu tests passed\n", test_registry().size()); \
+    return 0;                                                   \
+  }
+
+inline std::vector<std::pair<const char *, void (*)()>> &test_registry()
+{
+  static std::vector<std::pair<const char *, void (*)()>> tests;
+  return tests;
+}
+
+inline bool test_add(const char *name, void (*fn)())
+{
+  test_registry().emplace_back(name, fn);
+  return true;
+}
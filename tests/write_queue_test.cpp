@@ -0,0 +1,138 @@
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "shell/lib/webserver/write_queue.impl.h"
+#include "test.h"
+
+static constexpr std::size_t fragment_size = 64 * 1024;
+
+struct received
+{
+  std::vector<std::string> control;
+  std::vector<std::string> messages;
+  std::map<uint32_t, std::string> fragments;
+  std::size_t frames = 0;
+};
+
+// writes up to limit frames and reassembles them the way the frontend does
+static void drain(websocket_write_queue &queue, received &result, std::size_t limit = SIZE_MAX)
+{
+  auto &fragments = result.fragments;
+  auto &frames = result.frames;
+  while (!queue.empty() && limit-- > 0)
+  {
+    auto frame = queue.pop();
+    frames += 1;
+    std::string payload(frame.message.data->data() + frame.payload_offset, frame.payload_size);
+    if (frame.header_size == 0)
+    {
+      result.messages.push_back(payload);
+    }
+    else if (frame.header[0] == WEBSOCKET_FRAME_CONTROL)
+    {
+      CHECK(frame.header_size == 1);
+      result.control.push_back(payload);
+    }
+    else if (frame.header[0] == WEBSOCKET_FRAME_BINARY)
+    {
+      result.messages.push_back(payload);
+    }
+    else
+    {
+      CHECK(frame.header[0] == WEBSOCKET_FRAME_FRAGMENT);
+      CHECK((frame.header[1] & WEBSOCKET_FRAGMENT_CONTROL) == 0);
+      uint32_t id = 0;
+      for (auto i = 0; i < 4; ++i)
+      {
+        id |= static_cast<uint32_t>(frame.header[2 + i]) << (8 * i);
+      }
+      fragments[id] += payload;
+      if (frame.header[1] & WEBSOCKET_FRAGMENT_LAST)
+      {
+        result.messages.push_back(fragments[id]);
+        fragments.erase(id);
+      }
+    }
+    queue.requeue(std::move(frame));
+  }
+}
+
+static websocket_message make(websocket_message_type type, std::string data)
+{
+  return websocket_message{type, std::make_shared<const std::string>(std::move(data))};
+}
+
+static std::string patch(int version, std::size_t size)
+{
+  return "{\"type\":\"state_patch\",\"version\":" + std::to_string(version) + ",\"patch\":\"" + std::string(size, 'x') + "\"}";
+}
+
+TEST(large_patch_does_not_get_overtaken)
+{
+  websocket_write_queue queue(fragment_size);
+  queue.push(make(WEBSOCKET_MESSAGE_CONTROL, patch(1, 3 * fragment_size)));
+  queue.push(make(WEBSOCKET_MESSAGE_CONTROL, patch(2, 10)));
+  queue.push(make(WEBSOCKET_MESSAGE_CONTROL, patch(3, 2 * fragment_size)));
+  queue.push(make(WEBSOCKET_MESSAGE_CONTROL, patch(4, 10)));
+
+  received result;
+  drain(queue, result);
+  CHECK(result.frames == 4);
+  CHECK(result.control.size() == 4);
+  for (auto i = 0; i < 4; ++i)
+  {
+    CHECK(result.control[i].find("\"version\":" + std::to_string(i + 1) + ",") != std::string::npos);
+  }
+  CHECK(result.control[0] == patch(1, 3 * fragment_size));
+}
+
+TEST(patches_interleaved_with_user_messages)
+{
+  websocket_write_queue queue(fragment_size);
+  queue.push(make(WEBSOCKET_MESSAGE_BINARY, std::string(5 * fragment_size, 'b')));
+  queue.push(make(WEBSOCKET_MESSAGE_CONTROL, patch(1, 2 * fragment_size)));
+  queue.push(make(WEBSOCKET_MESSAGE_TEXT, "small"));
+
+  // first frames go out, more patches arrive while the large message is still in flight
+  received result;
+  drain(queue, result, 2);
+  CHECK(result.control.size() == 1);
+  CHECK(result.fragments.size() == 1);
+  queue.push(make(WEBSOCKET_MESSAGE_CONTROL, patch(2, 10)));
+  queue.push(make(WEBSOCKET_MESSAGE_CONTROL, patch(3, fragment_size + 1)));
+  queue.push(make(WEBSOCKET_MESSAGE_CONTROL, patch(4, 10)));
+
+  drain(queue, result);
+  CHECK(result.fragments.empty());
+  CHECK(result.control.size() == 4);
+  for (auto i = 0; i < 4; ++i)
+  {
+    CHECK(result.control[i].find("\"version\":" + std::to_string(i + 1) + ",") != std::string::npos);
+  }
+
+  // the small message overtakes the fragmented one, which arrives complete
+  CHECK(result.messages.size() == 2);
+  CHECK(result.messages[0] == "small");
+  CHECK(result.messages[1] == std::string(5 * fragment_size, 'b'));
+}
+
+TEST(user_messages_keep_their_order_when_small)
+{
+  websocket_write_queue queue(fragment_size);
+  for (auto i = 0; i < 100; ++i)
+  {
+    queue.push(make(i % 2 ? WEBSOCKET_MESSAGE_BINARY : WEBSOCKET_MESSAGE_TEXT, std::to_string(i)));
+  }
+
+  received result;
+  drain(queue, result);
+  CHECK(result.frames == 100);
+  for (auto i = 0; i < 100; ++i)
+  {
+    CHECK(result.messages[i] == std::to_string(i));
+  }
+}
+
+TEST_MAIN()